@@ -0,0 +1,19 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/** The regression benchmark
+* Searches the built-in middlegame and endgame positions to a fixed depth with the classical evaluation and prints
+* the total node count, the wall time and the nodes per second. The node count is the signature of the search,
+* it must not change with patches that don't change the search or the evaluation.
+* NOTE: it drives the board and the ai player directly, nothing graphical is created
+*/
+namespace Bench
+{
+	/** Runs the benchmark and prints the results
+	* @param depth : The search depth of every position
+	* @retval : The total node count (the signature)
+	*/
+	unsigned long long Run(int depth);
+}
+
+#endif // __BENCH_H__
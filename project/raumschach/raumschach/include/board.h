@@ -4,6 +4,7 @@
 #include "utils.h"
 #include "piece.h"
 #include "random_generator.h"
+#include "nnue.h"
 
 class Move
 {
@@ -41,18 +42,32 @@ public:
 class MadeMove
 {
 public:
-	MadeMove() : removedPiece(), sourcePosition() {}
-	MadeMove(Piece p, ChessVector src) : removedPiece(p), sourcePosition(src) {}
-	MadeMove(const MadeMove& copy) : removedPiece(copy.removedPiece), sourcePosition(copy.sourcePosition) {}
+	MadeMove() : removedPiece(), sourcePosition(), promoted(false), reversiblePlies(0) {}
+	MadeMove(Piece p, ChessVector src, bool promotion = false) : removedPiece(p), sourcePosition(src), promoted(promotion), reversiblePlies(0) {}
+	MadeMove(const MadeMove& copy) : removedPiece(copy.removedPiece), sourcePosition(copy.sourcePosition), promoted(copy.promoted), reversiblePlies(copy.reversiblePlies) {}
 	inline MadeMove& operator=(const MadeMove& assign)
 	{
 		removedPiece = assign.removedPiece;
 		sourcePosition = assign.sourcePosition;
+		promoted = assign.promoted;
+		reversiblePlies = assign.reversiblePlies;
 		return *this;
 	}
 
 	Piece removedPiece;
 	ChessVector sourcePosition;
+	// true if the moved piece was a pawn that became a queen with this move
+	bool promoted;
+	// the count of the reversible plies of the board before the move, restored by the undo
+	int reversiblePlies;
+};
+
+// The pawn structure evaluation of a board, cached by the pawn hash
+struct PawnStructure
+{
+	unsigned long long pawnHash; // the pawn hash of the evaluated board
+	int score; // positive if the white pawns have the better structure
+	BitBoard passedPawns[Config::PCOLOUR_COUNT]; // the pawns that can't be stopped or captured by enemy pawns
 };
 
 class Board;
@@ -63,7 +78,9 @@ public:
 	BitBoardMovePool();
 	~BitBoardMovePool();
 
-	void Initalize(RandomGenerator * randGen);
+	// NOTE: the zobrist hash keys are generated from a fixed seed, so the hashes are the same between runs
+	// and can be used as keys in precalculated files (like the opening book)
+	void Initalize();
 	// used only for slight optimizations - the proper moves should still be calculated by the GetPieceMoves(...)
 	// but this is a lot faster and can be used just to check the visibility of piece and tile
 	inline BitBoard GetPieceFullMoves(Piece p) const
@@ -91,6 +108,24 @@ public:
 		return 0ULL;
 	}
 
+	// returns the hash value that is added to the board hash for the player that is on move
+	inline unsigned long long GetColourHash(Config::PlayerColour colour) const
+	{
+		return colourHashTable[colour];
+	}
+
+	// returns the tiles in which an enemy pawn could block or capture the pawn on its way to the reproduction
+	inline const BitBoard& GetPawnFrontSpan(Config::PlayerColour colour, coord pos) const
+	{
+		return pawnFrontSpanPool[colour][pos];
+	}
+
+	// returns all the tiles in the files next to the tile (x - 1 and x + 1)
+	inline const BitBoard& GetAdjacentFiles(coord pos) const
+	{
+		return adjacentFilesPool[pos];
+	}
+
 	/** calculates the posible moves for the speicified piece by checking for blocking friendly or enemy pieces
 	@param p: The piece which moves we are checking
 	@param friendlyPieces: The BitBoard of the friendly pieces, we could obtain it but this is easier
@@ -102,7 +137,7 @@ public:
 
 private:
 	// initializes the zobrist hash table
-	void InitZobristHash(RandomGenerator * randGen);
+	void InitZobristHash();
 
 	// disable copy and assign
 	BitBoardMovePool(const BitBoardMovePool&);
@@ -112,8 +147,11 @@ private:
 
 	BitBoard * pool[Config::PIECE_TYPE_COUNT + 1];
 	BitBoard * pawnCapturePool[Config::PCOLOUR_COUNT];
+	BitBoard * pawnFrontSpanPool[Config::PCOLOUR_COUNT];
+	BitBoard * adjacentFilesPool;
 
 	unsigned long long * hashTable[Config::PIECE_TYPE_COUNT * 2];
+	unsigned long long colourHashTable[Config::PCOLOUR_COUNT];
 
 	DynamicArray<ChessVector> vectorPool[Config::PIECE_TYPE_COUNT + 1];
 };
@@ -194,6 +232,18 @@ public:
 		}
 	}
 
+	// Returns the pieces with the specified colour (without copying them)
+	inline const DynamicArray<Piece>& GetPieces(Config::PlayerColour colour) const
+	{
+		return pieces[colour];
+	}
+
+	// Returns the count of all the pieces on the board
+	inline int GetPieceCount() const
+	{
+		return pieces[Config::WHITE].Count() + pieces[Config::BLACK].Count();
+	}
+
 	/** Retrieves all the possible moves a player can make on the given board
 	* @param colour[in] : The colour of the player, which moves we're getting
 	* @param moveArray[out] : The destination array in which the moves will be pushed
@@ -234,6 +284,10 @@ public:
 	bool KingInCheck(Config::PlayerColour col) const;
 	// returns true if the king with the specified colour is under check
 	Config::KingState KingCheckState(Config::PlayerColour col);
+	/** Returns true if the player has at least one legal move
+	* NOTE: cheaper than GetPossibleMoves(...), the pins and the checks limit the tested moves and the first legal one ends the test
+	*/
+	bool HasLegalMove(Config::PlayerColour col);
 	// returns true if the game is stalemate by pieces
 	bool PieceStalemate() const;
 	// returns true if the tile is threatened by any piece of the specified player colour
@@ -244,27 +298,72 @@ public:
 
 	/** Returns the current material balance
 	* NOTE: The value is positive if the White pieces have more material and negative if the black do.
+	* The piece worth and position worth are kept up to date by every board change, only the mobility is calculated here.
 	*/
 	int GetMaterialBalance() const;
 
-	// Returns the hash of the current board
-	inline unsigned long long GetHash() const
+	// Recalculates the incrementally kept piece worth and position worth from scratch and checks it against the kept one
+	bool VerifyMaterialScore() const;
+
+	// Returns the hash of the pawns on the board (the promoted pawns are not counted)
+	inline unsigned long long GetPawnHash() const
 	{
-		unsigned long long hash = 0ULL;
+		return pawnHash;
+	}
 
-		for(int i = 0; i < pieces[Config::WHITE].Count(); ++i)
-		{
-			hash ^= movePool->GetPieceHash(pieces[Config::WHITE][i]);
-		}
+	/** Evaluates the pawn structure of the board (passed, isolated and blocked pawns)
+	* @param result[out] : The pawn structure score (positive if it is better for white), the passed pawns and the pawn hash
+	*/
+	void EvaluatePawnStructure(PawnStructure& result) const;
 
-		for(int i = 0; i < pieces[Config::BLACK].Count(); ++i)
-		{
-			hash ^= movePool->GetPieceHash(pieces[Config::BLACK][i]);
-		}
+	// Recalculates the board hash from scratch and checks it against the kept one
+	bool VerifyHash() const;
+
+	/** Sets the evaluation network, whose first layer is kept up to date by the board from now on
+	* @param net : The network (not owned by the board), or nullptr to stop updating it
+	*/
+	void SetNetwork(const NnueNetwork * net);
+
+	// Returns the evaluation network of the board, or nullptr if the board has none
+	inline const NnueNetwork * GetNetwork() const
+	{
+		return network;
+	}
+
+	// Returns the network first layer of the current position
+	inline const NnueAccumulator& GetAccumulator() const
+	{
+		return accumulator;
+	}
 
+	// Recalculates the network first layer from scratch and checks it against the kept one
+	bool VerifyAccumulator() const;
+
+	// Returns the hash of the current board (kept up to date by every board change)
+	inline unsigned long long GetHash() const
+	{
 		return hash;
 	}
 
+	// Returns the hash of the current board together with the player on move
+	// NOTE: this is the key for positions in the precalculated files
+	inline unsigned long long GetPositionHash(Config::PlayerColour colourToMove) const
+	{
+		return GetHash() ^ movePool->GetColourHash(colourToMove);
+	}
+
+	/** Returns true if the current position has already been on the board since the last capture or pawn move
+	* NOTE: the board doesn't know the player on move, so only every second position is compared
+	* and the position should be checked right after a move
+	*/
+	bool IsRepetition() const;
+
+	// Returns the count of the plies made since the last capture or pawn move
+	inline int GetReversiblePlies() const
+	{
+		return reversiblePlies;
+	}
+
 	// Returns the worth of the tile
 	int GetTileWorth(ChessVector pos) const;
 
@@ -281,9 +380,66 @@ public:
 
 	void AddPiece(Piece piece);
 	void RemovePiece(ChessVector pos);
+	// removes all the pieces from the board
+	void Clear();
 
 	void SetMovePool(BitBoardMovePool * pool);
 private:
+	// Returns the piece worth together with its position worth, positive for white pieces and negative for black ones
+	inline static int GetPieceScore(Piece piece)
+	{
+		const int score = piece.GetWorth() + piece.GetPositionWorth(piece.GetPositionVector());
+		return piece.GetColour() == Config::WHITE ? score : -score;
+	}
+
+	// Calculates the piece worth and position worth balance of all the pieces on the board
+	int CalculateMaterialScore() const;
+
+	// Returns the zobrist hash of the piece, or 0 if the board has no move pool
+	inline unsigned long long GetPieceHash(Piece piece) const
+	{
+		return movePool ? movePool->GetPieceHash(piece) : 0ULL;
+	}
+
+	// Adds or removes the piece from the board hash (and from the pawn hash if it is a pawn)
+	inline void TogglePieceHash(Piece piece)
+	{
+		const unsigned long long pieceHash = GetPieceHash(piece);
+		hash ^= pieceHash;
+		if(piece.GetType() == Config::PAWN)
+		{
+			pawnHash ^= pieceHash;
+		}
+	}
+
+	/** Adds or removes the piece from the network first layer (if the board has a network)
+	* @param moving : true if the piece is only moved, so it is added back on another tile in the same board change
+	*/
+	inline void UpdateAccumulator(Piece piece, bool add, bool moving = false)
+	{
+		if(network)
+		{
+			UpdateNetworkFeatures(piece, add, moving);
+		}
+	}
+
+	// Applies the piece features of all the perspectives, marking the perspectives whose king bucket changed as dirty
+	void UpdateNetworkFeatures(Piece piece, bool add, bool moving);
+	// Calculates the perspective of the network first layer from scratch
+	void RefreshAccumulator(Config::PlayerColour perspective);
+
+	// Refreshes the perspectives whose king bucket changed during the last board change
+	inline void RefreshDirtyAccumulators()
+	{
+		if(accumulatorDirty[Config::WHITE])
+			RefreshAccumulator(Config::WHITE);
+		if(accumulatorDirty[Config::BLACK])
+			RefreshAccumulator(Config::BLACK);
+	}
+
+	// Calculates the hash of all the pieces (or only of the pawns) on the board
+	unsigned long long CalculateHash(bool pawnsOnly = false) const;
+
 	inline Config::PlayerColour GetPieceColour(ChessVector pos) const
 	{
 		Config::PlayerColour colour = Config::BOTH_COLOURS;
@@ -319,5 +475,25 @@ private:
 
 	DynamicArray< Piece > pieces[Config::PCOLOUR_COUNT];
 	BitBoardMovePool * movePool;
+
+	// the piece worth and position worth balance, updated with every move, so the evaluation doesn't have to sum it
+	int materialScore;
+	// the zobrist hash of the pieces, updated with every move
+	unsigned long long hash;
+	// the zobrist hash of the pawns only, the key of the pawn structure evaluation
+	unsigned long long pawnHash;
+
+	// the board hashes before every made move (of the game and of the search path), for the repetition detection
+	DynamicArray<unsigned long long> hashHistory;
+	// the count of the plies since the last capture or pawn move, the positions before it can't be repeated
+	int reversiblePlies;
+
+	// the evaluation network, the accumulator is updated only if the board has one
+	const NnueNetwork * network;
+	NnueAccumulator accumulator;
+	// the king buckets the accumulator perspectives were calculated for
+	int accumulatorKingBuckets[Config::PCOLOUR_COUNT];
+	// the perspectives whose king bucket changed during the current board change and have to be calculated again
+	bool accumulatorDirty[Config::PCOLOUR_COUNT];
 };
 #endif // __BOARD_H__
\ No newline at end of file
@@ -66,14 +66,39 @@ namespace Config
 	{
 		PLAYER_HUMAN,
 		PLAYER_AI,
+		PLAYER_MCTS,
 		PLAYERS_TYPE_COUNT,
 	};
 
 	static const int AI_PLAYER_SEARCH_DEPTH = 4;
 	static const int INITIAL_ITERATIVE_DEEPENING = 0;
 	static const int MAX_AI_PLAYER_SEARCH_DEPTH = 10;
+	static const unsigned long long AI_PLAYER_STEP_NODES = 2000ULL; // the nodes the ai player searches between two passes of the event loop
+	static const int BENCH_DEPTH = 4; // the default search depth of the benchmark positions
+	static const unsigned DETERMINISTIC_SEED = 123u; // the seed of the move randomization in the deterministic mode
+	static const unsigned long long DETERMINISTIC_NODE_LIMIT = 2000000ULL; // the node budget of every ai search in the deterministic mode
+	static const int MAX_SEARCH_PLY = 64; // the maximum ply the preallocated search structures can reach
+	static const int HASH_HISTORY_SIZE = 256; // the initial capacity of the board hash history (the game and the search plies)
+	static const int TRANSITION_TABLE_SIZE = 1 << 17; // the count of entries in the transition table of every ai player (power of two)
+	static const int EVAL_CACHE_SIZE = 1 << 16; // the default count of entries in the evaluation cache of every ai player (power of two)
+	static const int PAWN_HASH_SIZE = 1 << 12; // the count of entries in the pawn structure table of every ai player (power of two)
 	static const int INT_NEGATIVE_INFINITY = 1 << (sizeof(int) * 8 - 1);
 	static const int INT_POSITIVE_INFINITY = ~ INT_NEGATIVE_INFINITY;
+	static const int MATE_SCORE = 1 << 20; // the score of a mate on the root, every ply to the mate lowers it by one
+	static const int MATE_THRESHOLD = MATE_SCORE - MAX_SEARCH_PLY; // the scores further from zero are mate scores
+	static const int SEARCH_INFINITY = MATE_SCORE + 1; // the bound of the search window (symmetric, so it can be negated)
+
+	static const int MCTS_PLAYOUTS = 20000; // the playouts of every move of the monte carlo player
+	static const int MCTS_STEP_PLAYOUTS = 200; // the playouts the monte carlo player plays between two passes of the event loop
+	static const int MCTS_NODE_POOL_SIZE = 1 << 19; // the count of the preallocated tree nodes of every monte carlo player
+	static const int MCTS_PLAYOUT_PLIES = 4; // the plies played out from a new leaf before its position is evaluated
+	static const int MCTS_VIRTUAL_LOSS = 3; // the lost playouts added to the nodes on the path of a running playout
+	static const int MCTS_RESULT_SCALE = 1024; // the won playout in the node value sums
+	static const int MCTS_EVAL_SCALE = 30; // the evaluation of the played out position, which counts as three quarters of a win
+	static const int MCTS_PRIOR_TEMPERATURE = 30; // the move heuristic difference, which makes the prior probability e times bigger
+	static const float MCTS_EXPLORATION = 1.5f; // the weight of the prior probability in the PUCT selection
+
+	static const int PROOF_SEARCH_NODES = 1 << 20; // the count of the nodes in the table of the proof-number search
 
 	static const int GAME_MAX_MOVES = 0;
 
@@ -134,6 +159,42 @@ namespace Config
 
 	static const int PLAYER_PIECES_COUNT = 20;
 
+	static const unsigned ZOBRIST_HASH_SEED = 0x5a0b1257u; // fixed, so the hashes are the same in every run
+
+	static const char PIECE_SQUARE_TABLE_FILENAME[] = "data/piecesquare.txt"; // optional weights replacing the default piece square tables
+
+	static const char NNUE_FILENAME[] = "data/network.nnue"; // optional network replacing the classical evaluation
+	static const char NNUE_MAGIC[8] = "RSNNUE1"; // the first bytes of every network file
+	static const int NNUE_KING_BUCKETS = 5; // the feature sets, chosen by the level of the perspective's king
+	static const int NNUE_PIECE_KINDS = 13; // six own piece types (without the king) and all the seven enemy ones
+	static const int NNUE_FEATURE_COUNT = NNUE_KING_BUCKETS * NNUE_PIECE_KINDS * BOARD_SIZE;
+	static const int NNUE_HIDDEN_SIZE = 128; // the accumulator size of a single perspective
+	static const int NNUE_HIDDEN2_SIZE = 32; // the size of the second (dense) layer
+	static const int NNUE_ACTIVATION_MAX = 127; // the clipped relu upper bound
+	static const int NNUE_HIDDEN_SHIFT = 6; // the dense layer output scaling (right shift)
+	static const int NNUE_OUTPUT_SCALE = 16; // the network output is divided by this to get the evaluation units
+
+	static const char POSITION_RECORD_MAGIC[8] = "RSPOS01"; // the first bytes of every labeled positions file
+	static const int POSITION_RECORD_MAX_PIECES = PLAYER_PIECES_COUNT * 2; // the pieces stored in a single position record
+	static const int POSITION_RECORD_BUFFER = 4096; // the count of records read or written at once
+
+	static const char OPENING_BOOK_FILENAME[] = "data/openings.bin";
+	static const char OPENING_BOOK_MAGIC[8] = "RSBOOK1"; // the first bytes of every opening book file
+	static const int OPENING_BOOK_MAX_PLIES = 4; // the default count of plies the book builder covers
+	static const int OPENING_BOOK_MOVES_PER_POSITION = 4; // the maximum count of moves kept for a position in the book
+
+	static const char TABLEBASE_DIRECTORY[] = "data/tablebases";
+	static const char TABLEBASE_EXTENSION[] = ".rstb";
+	static const char TABLEBASE_MAGIC[8] = "RSTB002"; // the first bytes of every tablebase file
+	static const int TABLEBASE_MAX_PIECES = 4; // the maximum count of pieces (kings included) in a tablebase
+	static const int TABLEBASE_MAX_SIGNATURE = 16; // the buffer size for material signatures like "KQvKR"
+	static const unsigned char TABLEBASE_DRAW = 0; // draw, or position with not determined result during the generation
+	static const unsigned char TABLEBASE_INVALID = 255; // impossible position (squares overlap or the player not on move is in check)
+	static const int TABLEBASE_WIN_SCORE = 40000; // the search score of a won tablebase position, reduced by the distance to mate
+
+	static const char SERVER_SOCKET_FILENAME[] = "/tmp/raumschach.sock"; // the default unix socket of the analysis server
+	static const int SERVER_HASH_SIZE = 256; // the default size of the shared transition table of the analysis server in megabytes
+
 	static const char BOARD_SAVE_FILENAME[] = "SavedBoard.dat";
 	static const int BOARD_SAVE_HEADER_SIZE = 2; // bytes in the save file that will be used for header flags
 	static const int BOARD_STATE_TURN_COLOUR_LSHIFT = 0;
@@ -305,6 +366,22 @@ namespace GraphicConfig
 		BUTTON_SIZE_HEIGHT, // height
 	};
 
+	static const int POSITION_BUTTON_NEW_MCTS_WHITE[] =
+	{
+		BUTTON_SIZE_WIDTH * 2 + PANEL_PADDING * 3, // x
+		BUTTON_POSITION_HORIZONTAL, // y
+		BUTTON_SIZE_WIDTH, // width
+		BUTTON_SIZE_HEIGHT, // height
+	};
+
+	static const int POSITION_BUTTON_NEW_MCTS_BLACK[] =
+	{
+		BUTTON_SIZE_WIDTH * 3 + PANEL_PADDING * 4, // x
+		BUTTON_POSITION_HORIZONTAL, // y
+		BUTTON_SIZE_WIDTH, // width
+		BUTTON_SIZE_HEIGHT, // height
+	};
+
 	static const int POSITION_BUTTON_NEW_HUMAN_BLACK[] =
 	{
 		PANEL_SIZE_WIDTH - PANEL_PADDING * 6 - BUTTON_SIZE_WIDTH * 5, // x
@@ -235,6 +235,13 @@ namespace Const
 	};
 
 	static const coord PAWN_DISTANCE_TO_REPRODUCTION = 7;
+	static const int PAWN_ADVANCEMENT_WORTH = 2; // every step a pawn made towards the reproduction
+
+	// pawn structure evaluation
+	static const int PAWN_PASSED_WORTH = 5; // every passed pawn
+	static const int PAWN_PASSED_STEP_WORTH = 3; // every step a passed pawn made towards the reproduction
+	static const int PAWN_ISOLATED_PENALTY = 4; // pawn without friendly pawns in the neighbour files
+	static const int PAWN_BLOCKED_PENALTY = 3; // pawn that can't move forward because of other pawns
 };
 
 #endif // __CONSTANTS_H__
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+// Read only memory mapped file, used for the large precalculated data files (opening book, tablebases)
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/** Maps the whole file in memory for reading
+	* @param filename : The path to the file to be mapped
+	* @retval : true if the file was mapped successfully
+	*/
+	bool Open(const char * filename);
+
+	// Unmaps the file (if it is mapped)
+	void Close();
+
+	bool IsOpen() const;
+
+	// Returns a pointer to the beginning of the mapped data, or nullptr if no file is mapped
+	const unsigned char * GetData() const;
+
+	// Returns the size of the mapped data in bytes
+	unsigned long long GetSize() const;
+
+private:
+	// disable copy and assign
+	MappedFile(const MappedFile& copy);
+	MappedFile& operator=(const MappedFile& assign);
+
+	const unsigned char * data;
+	unsigned long long size;
+
+	// platform specific handles
+	void * fileHandle;
+	void * mappingHandle;
+};
+
+#endif // __MAPPEDFILE_H__
@@ -0,0 +1,153 @@
+#ifndef __MCTSPLAYER_H__
+#define __MCTSPLAYER_H__
+
+#include "player.h"
+#include <atomic>
+
+class RandomGenerator;
+
+enum MCTSNodeState
+{
+	MCTS_LEAF, // the children are not generated yet
+	MCTS_EXPANDING, // a thread is generating the children, the others play out from the node meanwhile
+	MCTS_EXPANDED, // the children are ready (none for the mates and stalemates)
+};
+
+// A node of the monte carlo tree, reached by the move from its parent
+struct MCTSNode
+{
+	std::atomic<int> visits; // the finished playouts through the node, with the virtual losses of the running ones
+	std::atomic<long long> value; // the sum of the playout results for the player who made the move, in MCTS_RESULT_SCALE units
+	std::atomic<int> state; // the MCTSNodeState
+	int firstChild; // the pool index of the first child, the children are next to each other
+	int childCount;
+	float prior; // the probability of the move before any playout, from the move heuristic
+	coord source;
+	coord destination;
+};
+
+/** Preallocated nodes of the monte carlo tree, shared by the searching threads
+* NOTE: the nodes are never freed one by one, the whole pool is cleared before every search
+*/
+class MCTSNodePool
+{
+public:
+	MCTSNodePool(int capacity = Config::MCTS_NODE_POOL_SIZE);
+	~MCTSNodePool();
+
+	/** Takes the consecutive nodes from the pool (from any thread)
+	* @retval : The index of the first node, or -1 if the pool doesn't have enough nodes left
+	*/
+	int Allocate(int count);
+
+	// Returns all the nodes to the pool
+	void Clear();
+
+	// Returns the count of the taken nodes
+	int GetUsed() const;
+
+	inline MCTSNode& operator[](int index)
+	{
+		return nodes[index];
+	}
+
+private:
+	// disable copy and assignment
+	MCTSNodePool(const MCTSNodePool& copy);
+	MCTSNodePool& operator=(const MCTSNodePool& assign);
+
+	MCTSNode * nodes;
+	int capacity;
+	std::atomic<int> used;
+};
+
+// The state of the search run in steps by the MCTSPlayer
+struct MCTSSteppedSearch
+{
+	Board board; // the copy of the searched board
+	Config::PlayerColour colour;
+	unsigned long long rootHash; // the hash of the searched position (with the player on move)
+	int playoutsLeft; // the playouts not played yet
+	int step; // the count of the finished steps, the playouts of every step are seeded differently
+	bool active; // the search has started and hasn't finished yet
+};
+
+/** The monte carlo tree search player (PUCT selection with the move heuristic priors)
+* Every playout walks the tree to a leaf, expands it, plays a few random moves (preferring the captures) and evaluates
+* the reached position. The threads share the tree, the virtual losses of the running playouts turn the others to other paths.
+*/
+class MCTSPlayer : public Player
+{
+public:
+	/** Creates the player
+	* @param playouts : The count of the playouts of every move
+	* @param threads : The count of the threads sharing the tree
+	* @param seed : The seed of the playouts, the single threaded player with the same seed always plays the same moves
+	*/
+	MCTSPlayer(int playouts, int threads, Config::PlayerColour colour, unsigned seed = Config::DETERMINISTIC_SEED);
+	~MCTSPlayer();
+
+	Config::PlayerType GetType() const;
+
+	bool GetMove(Piece& piece, ChessVector& pos, const Board * board) const;
+
+	/** Searches the best move for the specified player
+	* @retval : The most visited move, with its average playout result converted to the evaluation units in the heuristic field,
+	* or an empty move if the player has no move
+	*/
+	Move Search(const Board& board, Config::PlayerColour colour) const;
+
+	/** Starts the search of the best move for the specified player, which is then run in steps by the StepSearch(...)
+	* NOTE: the search keeps its own copy of the board, any running stepped search is abandoned
+	*/
+	void BeginSearch(const Board& board, Config::PlayerColour colour) const;
+
+	/** Continues the search started by the BeginSearch(...)
+	* @param count : The count of the playouts played in this step, or 0 to play all the remaining playouts
+	* @retval : true if the search has finished (or no search is running)
+	*/
+	bool StepSearch(int count) const;
+
+	// Returns the best move of the stepped search (of the playouts played so far), in the same form as the Search(...)
+	Move GetSearchResult() const;
+
+	/** Thinks about the player's move in steps, like the GetMove(...) without blocking the caller for the whole search
+	* The first call (or a call with another board or player on move than the running search) starts the search anew
+	* @param count : The count of the playouts played in this call, or 0 to play until the move is found
+	* @retval : true if the move was found and written to the piece and the pos
+	*/
+	bool ThinkMove(Piece& piece, ChessVector& pos, const Board * board, int count) const;
+
+	// Returns the count of the tree nodes of the last search
+	int GetTreeSize() const;
+
+private:
+	// the playouts of a single thread, until the shared playout counter runs out
+	void RunPlayouts(const Board& root, Config::PlayerColour colour, unsigned seed) const;
+
+	/** Generates the children of the node with their priors
+	* @retval : false if the pool is full and the node stays a leaf
+	*/
+	bool Expand(MCTSNode& node, Board& board, Config::PlayerColour colour, DynamicArray<Move>& moves) const;
+
+	// Returns the child with the best PUCT score
+	int SelectChild(const MCTSNode& node) const;
+
+	// Plays the random moves from the leaf and returns the result for the player on move, from -MCTS_RESULT_SCALE to MCTS_RESULT_SCALE
+	int Playout(Board& board, Config::PlayerColour colour, DynamicArray<Move>& moves, RandomGenerator& rgen) const;
+
+	// The heuristic of the move for the priors and the playouts (the captured piece and the position worth)
+	static int MoveHeuristic(const Move& move, const Board& board);
+
+	const int playouts;
+	const int threadCount;
+	const unsigned seed;
+
+	MCTSNodePool * pool;
+	MCTSSteppedSearch * stepped;
+
+	// the playouts left in the running step
+	mutable std::atomic<int> remainingPlayouts;
+};
+
+#endif // __MCTSPLAYER_H__
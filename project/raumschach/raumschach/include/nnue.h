@@ -0,0 +1,83 @@
+#ifndef __NNUE_H__
+#define __NNUE_H__
+
+#include "configuration.h"
+#include "piece.h"
+#include "utils.h"
+
+// The first layer outputs for both perspectives, kept up to date by the board
+struct NnueAccumulator
+{
+	short values[Config::PCOLOUR_COUNT][Config::NNUE_HIDDEN_SIZE];
+};
+
+/** Efficiently updatable evaluation network.
+* The features are the pieces on the tiles from the perspective of each player, grouped by the level of the player's king.
+* The black perspective is mirrored (y and z reversed), so both players see their pawns moving in the same direction.
+* The first layer is kept by the board in a NnueAccumulator and updated with every move, only the small dense layers
+* are calculated for every evaluation.
+*
+* The network file (in native byte order) is a NnueHeader followed by:
+*	short featureWeights[NNUE_FEATURE_COUNT][NNUE_HIDDEN_SIZE]
+*	short featureBiases[NNUE_HIDDEN_SIZE]
+*	short hiddenWeights[NNUE_HIDDEN2_SIZE][NNUE_HIDDEN_SIZE * 2] (white perspective inputs first)
+*	int hiddenBiases[NNUE_HIDDEN2_SIZE]
+*	short outputWeights[NNUE_HIDDEN2_SIZE]
+*	int outputBias
+*/
+class NnueNetwork
+{
+public:
+	NnueNetwork();
+	~NnueNetwork();
+
+	// Loads the network, returns false if the file is missing or doesn't match the network dimensions
+	bool Load(const char * filename);
+	bool IsLoaded() const;
+
+	// Returns the feature set of the king position for the specified perspective
+	static int GetKingBucket(Config::PlayerColour perspective, coord kingPos);
+
+	/** Returns the feature index of the piece
+	* @param perspective : The player from whose perspective the feature is taken
+	* @param kingBucket : The perspective's king bucket from GetKingBucket(...)
+	* @param piece : The piece on the board
+	* @retval : The feature index, or -1 if the piece isn't a feature (the perspective's own king)
+	*/
+	static int GetFeatureIndex(Config::PlayerColour perspective, int kingBucket, Piece piece);
+
+	// Sets the accumulator of a single perspective to the first layer biases
+	void ResetAccumulator(short * accumulator) const;
+	// Adds the feature weights to the accumulator of a single perspective
+	void AddFeature(short * accumulator, int feature) const;
+	// Subtracts the feature weights from the accumulator of a single perspective
+	void SubtractFeature(short * accumulator, int feature) const;
+
+	// Evaluates the accumulated position, the result is positive if the position is better for white
+	int Evaluate(const NnueAccumulator& accumulator) const;
+
+private:
+	// disable copy and assign
+	NnueNetwork(const NnueNetwork& copy);
+	NnueNetwork& operator=(const NnueNetwork& assign);
+
+	void Free();
+
+	short * featureWeights;
+	short * featureBiases;
+	short * hiddenWeights;
+	int * hiddenBiases;
+	short * outputWeights;
+	int outputBias;
+};
+
+// The header of the network file
+struct NnueHeader
+{
+	char magic[8];
+	unsigned int featureCount;
+	unsigned int hiddenSize;
+	unsigned int hidden2Size;
+};
+
+#endif // __NNUE_H__
@@ -0,0 +1,85 @@
+#ifndef __NOTATION_H__
+#define __NOTATION_H__
+
+#include "configuration.h"
+#include "charstring.h"
+#include "board.h"
+#include "piece.h"
+#include "utils.h"
+#include <vector>
+
+/** The text notation of the tiles, moves and positions
+* A tile is written as its level (A - E), file (a - e) and rank (1 - 5), e.g. the white king starts on "Ac1",
+* which is the tile (2, 0, 0) - the file is the x, the rank is the y and the level is the z coordinate.
+* A piece is its letter (K, Q, R, B, N, U, P - upper case for white, lower case for black) followed by its tile.
+* A position is the player on move ('w' or 'b') followed by the pieces separated by spaces, e.g. "w KAc1 QBc1 kEc5 qDc5".
+* A move is the source and the destination tile, e.g. "Bc2Cc3".
+*/
+namespace Notation
+{
+	static const int TILE_LENGTH = 3;
+	static const int MOVE_LENGTH = TILE_LENGTH * 2;
+
+	// Writes the tile name and the terminating zero to the output (at least TILE_LENGTH + 1 characters)
+	void FormatTile(ChessVector pos, char * output);
+	// Reads the tile name from the start of the input, returns false if it isn't a valid tile
+	bool ParseTile(const char * input, ChessVector& pos);
+
+	// Returns the letter of the piece (upper case for the white pieces)
+	char GetPieceLetter(Piece piece);
+
+	// Writes the move source and destination tiles and the terminating zero to the output (at least MOVE_LENGTH + 1 characters)
+	void FormatMove(const Move& move, char * output);
+
+	/** Reads the move and finds it in the possible moves of the player on move
+	* @param input : The move text (source and destination tile)
+	* @param board : The board on which the move is made
+	* @param colour : The player on move
+	* @param move[out] : The legal move, ready to be made on the board
+	* @retval : false if the text isn't a legal move of the player
+	*/
+	bool ParseMove(const char * input, Board& board, Config::PlayerColour colour, Move& move);
+
+	/** Reads the position
+	* @param input : The position text
+	* @param pieces[out] : The pieces of the position
+	* @param colourToMove[out] : The player on move
+	* @retval : false if the text isn't a valid position (unknown tokens, two pieces on a tile or the kings missing)
+	*/
+	bool ParsePosition(const char * input, DynamicArray<Piece>& pieces, Config::PlayerColour& colourToMove);
+
+	// Returns the position text of the board with the player on move
+	CharString FormatPosition(const Board& board, Config::PlayerColour colourToMove);
+
+	// The limits of the search command "go [depth <plies>] [nodes <count>] [movetime <ms>] [infinite]"
+	struct SearchLimits
+	{
+		SearchLimits();
+
+		int depth;
+		unsigned long long nodes; // 0 if the nodes aren't limited
+		long long moveTime; // in milliseconds, 0 if the time isn't limited
+		bool infinite; // the search runs until it is stopped
+	};
+
+	// Splits the command line to the tokens separated by white spaces, the buffer keeps their characters
+	// NOTE: the line is split by hand (not by strtok), so the commands of different threads can be split at once
+	void SplitCommand(const char * line, std::vector<char>& buffer, std::vector<const char *>& tokens);
+
+	/** Reads the position command "position startpos|<position> [moves <move>...]" and plays its moves
+	* @param tokens : The command tokens (the first one is the command name)
+	* @param movePool : The move pool of the board
+	* @param board[out] : The board after the moves, left unchanged if the command isn't valid
+	* @param colourToMove[out] : The player on move after the moves, left unchanged if the command isn't valid
+	* @param error[out] : The error text ("invalid position" or "illegal move <move>") if the command isn't valid
+	* @retval : false if the position or one of the moves isn't valid
+	*/
+	bool ParsePositionCommand(const std::vector<const char *>& tokens, BitBoardMovePool * movePool, Board& board,
+		Config::PlayerColour& colourToMove, CharString& error);
+
+	// Reads the limits of the search command (the first token is the command name), the limited searches without
+	// the depth are deepened as far as they get
+	SearchLimits ParseSearchCommand(const std::vector<const char *>& tokens);
+}
+
+#endif // __NOTATION_H__
@@ -0,0 +1,73 @@
+#ifndef __OPENINGBOOK_H__
+#define __OPENINGBOOK_H__
+
+#include "configuration.h"
+#include "mappedfile.h"
+#include "piece.h"
+#include "utils.h"
+
+class Board;
+class RandomGenerator;
+
+// A single book move, the records are written to the file sorted by their hash
+struct BookEntry
+{
+	unsigned long long hash; // the position hash from Board::GetPositionHash(...)
+	unsigned char source; // the coord of the moved piece
+	unsigned char destination; // the coord of the destination
+	unsigned short weight; // the relative probability of the move being chosen
+	int score; // the score of the move from the search that generated it (for information only)
+};
+
+// The header of the opening book file, followed by the BookEntry records
+struct BookHeader
+{
+	char magic[8];
+	unsigned int entryCount;
+	unsigned int plies; // the count of plies the book was generated for
+};
+
+/** Opening book, that is memory mapped from a file with fixed size records, sorted by the position hash
+* NOTE: the file is written in the native byte order by the book builder
+*/
+class OpeningBook
+{
+public:
+	OpeningBook();
+	~OpeningBook();
+
+	// Opens the book file, returns false if the file is missing or isn't a valid book
+	bool Open(const char * filename);
+	void Close();
+	bool IsOpen() const;
+
+	int GetEntryCount() const;
+
+	/** Finds all the book entries for the specified position
+	* @param hash : The position hash
+	* @param first[out] : Pointer to the first found entry
+	* @retval : The count of the found entries (they are consecutive, starting with first)
+	*/
+	int FindEntries(unsigned long long hash, const BookEntry *& first) const;
+
+	/** Chooses a book move for the current position by the weights of the book entries
+	* @param board : The current board
+	* @param colour : The player on move
+	* @param rgen : The random generator used for the weighted choice
+	* @param piece[out] : The piece that shall be moved
+	* @param pos[out] : The position, to which the piece shall be moved
+	* @retval : true if a valid book move was found
+	*/
+	bool GetMove(const Board& board, Config::PlayerColour colour, RandomGenerator * rgen, Piece& piece, ChessVector& pos) const;
+
+private:
+	// disable copy and assign
+	OpeningBook(const OpeningBook& copy);
+	OpeningBook& operator=(const OpeningBook& assign);
+
+	MappedFile file;
+	const BookEntry * entries;
+	int entryCount;
+};
+
+#endif // __OPENINGBOOK_H__
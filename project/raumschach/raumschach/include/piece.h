@@ -3,6 +3,7 @@
 
 #include "configuration.h"
 #include "utils.h"
+#include "piecesquaretable.h"
 
 class Piece
 {
@@ -87,7 +88,10 @@ public:
 	int GetWorth() const;
 
 	// Return the worth only of the specified position if the current piece occupies it
-	int GetPositionWorth(ChessVector pos) const;
+	inline int GetPositionWorth(ChessVector pos) const
+	{
+		return PieceSquareTable::GetWorth(GetColour(), GetType(), pos.GetVectorCoord());
+	}
 
 	friend bool operator<(const Piece& lhs, const Piece& rhs)
 	{
@@ -0,0 +1,61 @@
+#ifndef __PIECESQUARETABLE_H__
+#define __PIECESQUARETABLE_H__
+
+#include "configuration.h"
+#include "utils.h"
+
+/** Precalculated position worth of every piece type on every tile for both colours, together with the piece worth.
+* The tables are filled with the default formulas at startup and can be replaced by a weights file, so they
+* can be tuned without recompiling.
+* NOTE: the boards keep their position worth incrementally, so the tables have to be loaded before any board is created
+*/
+class PieceSquareTable
+{
+public:
+	// Returns the worth of the piece type with the specified colour on the tile
+	inline static int GetWorth(Config::PlayerColour colour, Config::PieceType type, coord pos)
+	{
+		return tables[colour][type][pos];
+	}
+
+	inline static void SetWorth(Config::PlayerColour colour, Config::PieceType type, coord pos, int worth)
+	{
+		tables[colour][type][pos] = worth;
+	}
+
+	// Returns the worth of the piece type, regardless of its position
+	inline static int GetPieceWorth(Config::PieceType type)
+	{
+		return pieceWorth[type];
+	}
+
+	inline static void SetPieceWorth(Config::PieceType type, int worth)
+	{
+		pieceWorth[type] = worth;
+	}
+
+	// Fills the tables with the default formulas (distance to the board center and pawn distance to promotion) and the default piece worth
+	static void Reset();
+
+	/** Fills the position tables with the default formulas, but with the specified weights
+	* @param positionFactors : The worth of a single tile distance to the board center for every piece type
+	* @param pawnAdvancement : The worth of a single pawn step towards the reproduction
+	*/
+	static void Generate(const int positionFactors[Config::PIECE_TYPE_COUNT], int pawnAdvancement);
+
+	/** Loads the tables from a text weights file. Every table starts with the colour and piece names (e.g. "White Knight")
+	* followed by the worth of all the tiles ordered by their coord. The piece worth is in lines like "Worth Queen 160".
+	* Tables and worth that are not in the file keep their values, and lines starting with '#' are ignored.
+	* @retval : false if the file is missing or malformed, the tables are left unchanged then
+	*/
+	static bool Load(const char * filename);
+
+	// Saves all the tables in the format read by Load(...)
+	static bool Save(const char * filename);
+
+private:
+	static int tables[Config::PCOLOUR_COUNT][Config::PIECE_TYPE_COUNT][Config::BOARD_SIZE];
+	static int pieceWorth[Config::PIECE_TYPE_COUNT];
+};
+
+#endif // __PIECESQUARETABLE_H__
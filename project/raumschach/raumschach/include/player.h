@@ -4,63 +4,367 @@
 #include "board.h"
 #include "piece.h"
 #include "utils.h"
-#include <unordered_map>
+#include "constants.h"
+#include <atomic>
 
 class RandomGenerator;
+class OpeningBook;
+class Tablebases;
+class NnueNetwork;
 
+// The kind of the score stored in the transition table
+enum TransitionBound
+{
+	BOUND_NONE,
+	BOUND_UPPER, // the search failed low, the position is worth at most the score
+	BOUND_LOWER, // the search failed high, the position is worth at least the score
+	BOUND_EXACT, // the score is the exact worth of the position
+};
+
+// A searched position in the transition table
+struct TransitionEntry
+{
+	unsigned long long hash; // the position hash (with the player on move)
+	int score; // the score for the player on move, the mate scores are relative to the position
+	short depth; // the depth the position was searched with
+	unsigned char bound; // the TransitionBound of the score
+	coord source; // the tile of the best move piece, or -1 if no move raised the alpha
+	coord destination; // the destination of the best move
+};
+
+/** Direct mapped table of the searched positions, keyed by the board hash together with the player on move
+* The entries keep the search score bounds for the cutoffs and the best moves for the move ordering and the principal variations
+* The table can be shared by the searching threads without locks: every entry is packed to a single word and stored together
+* with the hash xored by it, so an entry torn by two threads writing it at once fails the hash check and is never used
+*/
 class TransitionTable
 {
 public:
-	TransitionTable(int depth) : table(nullptr), tableSize(depth)
+	// The size is rounded down to a power of two
+	TransitionTable(int size = Config::TRANSITION_TABLE_SIZE);
+	~TransitionTable();
+
+	// Returns the count of entries that fit in the megabytes
+	static int GetSizeForMegabytes(int megabytes);
+
+	/** Searches for the position in the transition table
+	* @param hash : the position hash to be searched for in the transition table
+	* @param entry[out] : the entry of the position if it was found
+	* @return : true if the position is found, or false otherwise.
+	*/
+	inline bool GetEntry(unsigned long long hash, TransitionEntry& entry) const
+	{
+		const TransitionSlot& slot = entries[hash & mask];
+		const unsigned long long data = slot.data.load(std::memory_order_relaxed);
+		if((slot.key.load(std::memory_order_relaxed) ^ data) != hash || GetBound(data) == BOUND_NONE)
+			return false;
+
+		entry.hash = hash;
+		entry.score = (int) (data & SCORE_MASK) - SCORE_OFFSET;
+		entry.depth = (short) ((data >> DEPTH_SHIFT) & 0xff);
+		entry.bound = GetBound(data);
+		entry.source = GetCoord(data >> SOURCE_SHIFT);
+		entry.destination = GetCoord(data >> DESTINATION_SHIFT);
+		return true;
+	}
+
+	// Stores the search result of the position, only a deeper search of the same position is kept instead of it
+	inline void AddEntry(unsigned long long hash, int depth, int score, TransitionBound bound, coord source, coord destination)
+	{
+		TransitionSlot& slot = entries[hash & mask];
+		const unsigned long long stored = slot.data.load(std::memory_order_relaxed);
+		const bool samePosition = (slot.key.load(std::memory_order_relaxed) ^ stored) == hash && GetBound(stored) != BOUND_NONE;
+		if(samePosition && (int) ((stored >> DEPTH_SHIFT) & 0xff) > depth)
+			return;
+
+		// a failed low search has no best move, so the one from the previous search is still the best guess
+		unsigned long long move = ((unsigned long long) (unsigned char) source << SOURCE_SHIFT) | ((unsigned long long) (unsigned char) destination << DESTINATION_SHIFT);
+		if(samePosition && source < 0)
+		{
+			move = stored & (MOVE_MASK << SOURCE_SHIFT);
+		}
+
+		const unsigned long long data = ((unsigned long long) (score + SCORE_OFFSET) & SCORE_MASK) | ((unsigned long long) (depth & 0xff) << DEPTH_SHIFT)
+			| ((unsigned long long) bound << BOUND_SHIFT) | move;
+		slot.key.store(hash ^ data, std::memory_order_relaxed);
+		slot.data.store(data, std::memory_order_relaxed);
+	}
+
+	// Removes all the entries from the table
+	void Clear();
+
+	int GetSize() const;
+
+private:
+	// disable copy and assignment
+	TransitionTable(const TransitionTable& copy);
+	TransitionTable& operator=(const TransitionTable& assign);
+
+	// the packed entry - 24 bits of the score, 8 bits of the depth and the bound, the source and the destination of the best move
+	static const int SCORE_OFFSET = 1 << 23;
+	static const unsigned long long SCORE_MASK = 0xffffffULL;
+	static const unsigned long long MOVE_MASK = 0xffffULL;
+	static const int DEPTH_SHIFT = 24;
+	static const int BOUND_SHIFT = 32;
+	static const int SOURCE_SHIFT = 40;
+	static const int DESTINATION_SHIFT = 48;
+
+	static inline unsigned char GetBound(unsigned long long data)
+	{
+		return (unsigned char) ((data >> BOUND_SHIFT) & 0xff);
+	}
+
+	// the missing move (-1) is stored as 0xff
+	static inline coord GetCoord(unsigned long long data)
+	{
+		const int value = (int) (data & 0xff);
+		return (coord) (value == 0xff ? -1 : value);
+	}
+
+	struct TransitionSlot
+	{
+		std::atomic<unsigned long long> key; // the hash xored by the data
+		std::atomic<unsigned long long> data;
+	};
+
+	TransitionSlot * entries;
+	unsigned long long mask;
+};
+
+// A line of the multi-PV analysis
+struct AnalysisLine
+{
+	int score; // the exact score of the line for the player on move
+	DynamicArray<Move> moves; // the principal variation, starting with the analysed move
+};
+
+// Counters collected during a single search
+struct SearchStats
+{
+	SearchStats() { Clear(); }
+
+	void Clear()
+	{
+		nodes = 0ULL;
+		evalProbes = 0ULL;
+		evalHits = 0ULL;
+		pawnProbes = 0ULL;
+		pawnHits = 0ULL;
+		hashProbes = 0ULL;
+		hashHits = 0ULL;
+		depth = 0;
+		aborted = false;
+	}
+
+	// Returns the percentage of the evaluations that were found in the evaluation cache
+	float GetEvalHitRate() const
+	{
+		return evalProbes ? (float) evalHits * 100.0f / (float) evalProbes : 0.0f;
+	}
+
+	// Returns the percentage of the transition table probes that ended the search of the position
+	float GetHashHitRate() const
+	{
+		return hashProbes ? (float) hashHits * 100.0f / (float) hashProbes : 0.0f;
+	}
+
+	// Returns the percentage of the pawn structure evaluations that were found in the pawn hash table
+	float GetPawnHitRate() const
+	{
+		return pawnProbes ? (float) pawnHits * 100.0f / (float) pawnProbes : 0.0f;
+	}
+
+	unsigned long long nodes; // the count of the visited positions
+	unsigned long long evalProbes; // the count of the leaf evaluations
+	unsigned long long evalHits; // the count of the leaf evaluations found in the evaluation cache
+	unsigned long long pawnProbes; // the count of the pawn structure evaluations
+	unsigned long long pawnHits; // the count of the pawn structure evaluations found in the pawn hash table
+	unsigned long long hashProbes; // the count of the positions searched in the transition table
+	unsigned long long hashHits; // the count of the positions whose transition table score caused a cutoff
+	int depth; // the depth of the last finished root search
+	bool aborted; // true if the search ran out of its node budget, its unfinished results are thrown away
+};
+
+// The result of a finished depth of the iterative deepening
+struct SearchInfo
+{
+	int depth; // the finished depth
+	int score; // the score of the best move for the player on move
+	unsigned long long nodes; // the count of the positions visited by the search so far
+	DynamicArray<Move> pv; // the principal variation, starting with the best move
+};
+
+/** Receives the progress of the searches of an ai player
+* NOTE: it is called from the searching thread, in the middle of the search
+*/
+class SearchListener
+{
+public:
+	virtual ~SearchListener() {}
+
+	// Called after every finished depth of the iterative deepening
+	virtual void OnDepthFinished(const SearchInfo& info) = 0;
+};
+
+/** Direct mapped cache of the board evaluations, keyed by the board hash
+* NOTE: it is not thread safe, so every searching thread must use its own cache
+*/
+class EvalCache
+{
+public:
+	// The size is rounded down to a power of two
+	EvalCache(int size = Config::EVAL_CACHE_SIZE);
+	~EvalCache();
+
+	// Returns true and the cached evaluation if the hash is in the cache
+	inline bool GetValue(unsigned long long hash, int& value) const
 	{
-		table = new std::unordered_map<unsigned long long, int>[tableSize];
+		const EvalCacheEntry& entry = entries[hash & mask];
+		if(entry.hash == hash)
+		{
+			value = entry.value;
+			return true;
+		}
+		return false;
 	}
 
-	~TransitionTable()
+	// Stores the evaluation, replacing the entry that was in its place
+	inline void AddValue(unsigned long long hash, int value)
 	{
-		delete[] table;
-		table = nullptr;
+		EvalCacheEntry& entry = entries[hash & mask];
+		entry.hash = hash;
+		entry.value = value;
 	}
 
-	/** Searches for the hash in the transition table
-	* @param depth : the depth of the value to be searched
-	* @param hash : the hash to be searched for in the transition table
-	* @param value[out] : the value in the transition table if it was found, 0 otherwise
-	* @return : true if the hash is found, or false otherwise.
+	// Removes all the entries from the cache
+	void Clear();
+
+	int GetSize() const;
+
+private:
+	// disable copy and assignment
+	EvalCache(const EvalCache& copy);
+	EvalCache& operator=(const EvalCache& assign);
+
+	// NOTE: the empty entries have zero hash, which only the empty board has
+	struct EvalCacheEntry
+	{
+		unsigned long long hash;
+		int value;
+	};
+
+	EvalCacheEntry * entries;
+	unsigned long long mask;
+};
+
+/** Direct mapped table of the pawn structure evaluations, keyed by the board pawn hash
+* NOTE: it is not thread safe, so every searching thread must use its own table
+*/
+class PawnHashTable
+{
+public:
+	// The size is rounded down to a power of two
+	PawnHashTable(int size = Config::PAWN_HASH_SIZE);
+	~PawnHashTable();
+
+	/** Returns the pawn structure of the board, evaluating it only if it isn't in the table
+	* @param board : The evaluated board
+	* @param found[out] : true if the structure was found in the table
 	*/
-	bool GetValue(int depth, unsigned long long hash, int& value) const
+	inline const PawnStructure& GetStructure(const Board& board, bool& found)
 	{
-		auto got = table[depth].find(hash);
-		bool found = false;
-		if(got != table[depth].end())
+		const unsigned long long pawnHash = board.GetPawnHash();
+		PawnStructure& entry = entries[pawnHash & mask];
+		found = entry.pawnHash == pawnHash;
+		if(!found)
 		{
-			value = got->second;
-			found = true;
+			board.EvaluatePawnStructure(entry);
 		}
-		return found;
+		return entry;
 	}
 
-	// Adds a value with the specified hash at the specified depth
-	void AddValue(int depth, unsigned long long hash, int value)
+	// Removes all the entries from the table
+	void Clear();
+
+	int GetSize() const;
+
+private:
+	// disable copy and assignment
+	PawnHashTable(const PawnHashTable& copy);
+	PawnHashTable& operator=(const PawnHashTable& assign);
+
+	// NOTE: the empty entries have zero hash and score, which is the right evaluation for a board without pawns
+	PawnStructure * entries;
+	unsigned long long mask;
+};
+
+/** Preallocated move buffers for every ply of the search, so the search loop doesn't allocate
+* NOTE: every searching thread must use its own arena
+*/
+class MoveArena
+{
+public:
+	MoveArena(int plyCount, int movesPerPly = Const::MAX_PIECES_MOVES);
+	~MoveArena();
+
+	// Returns the cleared move buffer for the specified ply
+	inline DynamicArray<Move>& GetPlyMoves(int ply)
 	{
-		table[depth][hash] = value;
+		plyMoves[ply].Clear();
+		return plyMoves[ply];
 	}
 
-	// Clears the current table and allocates another
-	void Clear()
+	// Returns the move buffer for the specified ply as it is
+	inline DynamicArray<Move>& GetMoves(int ply)
 	{
-		delete[] table;
-		table = nullptr;
-		table = new std::unordered_map<unsigned long long, int>[tableSize];
+		return plyMoves[ply];
+	}
+
+	// Returns the number of plies the arena has buffers for
+	inline int GetPlyCount() const
+	{
+		return plyCount;
 	}
 
 private:
 	// disable copy and assignment
-	TransitionTable(const TransitionTable& copy);
-	TransitionTable& operator=(const TransitionTable& assign);
+	MoveArena(const MoveArena& copy);
+	MoveArena& operator=(const MoveArena& assign);
 
-	int tableSize;
-	std::unordered_map<unsigned long long, int> * table;
+	int plyCount;
+	DynamicArray<Move> * plyMoves;
+};
+
+// A node of the search on the explicit stack of the AIPlayer, which replaces the recursion of the alpha-beta
+struct SearchFrame
+{
+	int depth; // the remaining depth of the node
+	int alpha;
+	int beta;
+	Config::PlayerColour colour; // the player on move
+	unsigned long long positionHash;
+	int moveIndex; // the next searched move, or the searched one while its child frame is above on the stack
+	int bestIndex; // the move that raised the alpha, or -1
+	int firstMove; // the root frame searches its moves from this one and puts the best one in its place
+	bool root; // the root frame has no transition table entry and no node of its own
+	MadeMove madeMove; // the move to the child frame, undone when the child returns its score
+};
+
+/** The state of the search between the StepSearch(...) calls of the AIPlayer
+* The search stops between any two nodes and resumes later, as all its state is in the frames and the searched board
+*/
+struct SteppedSearch
+{
+	Board board; // the copy of the searched board, the moves of the frames on the stack are made on it
+	Config::PlayerColour colour;
+	unsigned long long rootHash; // the hash of the searched position (with the player on move)
+	int depth; // the maximum depth
+	int iterationDepth; // the depth of the running root search
+	bool iterative; // every depth from one is searched
+	bool active; // the search has started and hasn't finished yet
+	int top; // the ply of the topmost frame
+	Move bestMove; // the best move of the last finished depth
+	long long startClock; // the clock() at the start of the search
 };
 
 class Player
@@ -114,6 +418,112 @@ public:
 
 	bool GetMove(Piece& piece, ChessVector& pos, const Board * board) const;
 
+	/** Searches the best move for the specified player with the player's search depth
+	* @param board : The board to be searched
+	* @param colour : The player on move
+	* @retval : The best found move, with the search evaluation in its heuristic field
+	*/
+	Move Search(const Board& board, Config::PlayerColour colour) const;
+
+	/** Searches the best move of the restricted root moves with the specified depth
+	* @param depth : The maximum search depth, instead of the player's one
+	* @param searchMoves : The root moves to be searched (compared by their source and destination), all the moves if it is empty
+	* @retval : The best found move, with the search evaluation in its heuristic field, or an empty move if there is no move to search
+	*/
+	Move Search(const Board& board, Config::PlayerColour colour, int depth, const DynamicArray<Move>& searchMoves) const;
+
+	/** Searches for a forced mate, trying only the checking moves of the player and all the evasions of the enemy
+	* NOTE: it needs a fraction of the nodes of the full search, but misses the mates with quiet moves
+	* @param board : The board to be searched
+	* @param colour : The player on move, who gives the mate
+	* @param maxMoves : The longest searched mate in the moves of the player
+	* @param mateMove[out] : The first move of the shortest found mate
+	* @retval : The count of the player's moves to the mate, or 0 if no mate was found
+	*/
+	int FindMate(const Board& board, Config::PlayerColour colour, int maxMoves, Move& mateMove) const;
+
+	/** Searches the best moves with their exact scores and principal variations (multi-PV analysis)
+	* Every pass searches the root moves without the ones found by the previous passes. The passes share the transition table,
+	* so the later ones cost a fraction of an independent search.
+	* @param board : The board to be analysed
+	* @param colour : The player on move
+	* @param lineCount : The count of the searched lines (there are less if the player has less moves)
+	* @param lines[out] : The best lines, starting with the best one
+	*/
+	void Analyse(const Board& board, Config::PlayerColour colour, int lineCount, DynamicArray<AnalysisLine>& lines) const;
+
+	// Sets the opening book, which is consulted before searching (the book is not owned by the player)
+	void SetOpeningBook(const OpeningBook * book);
+
+	// Sets the endgame tablebases, which are probed by the search (the tablebases are not owned by the player)
+	void SetTablebases(const Tablebases * tables);
+
+	/** Sets the evaluation network, which replaces the classical evaluation in the search
+	* @param net : The network (not owned by the player), or nullptr to use the classical evaluation
+	*/
+	void SetNetwork(const NnueNetwork * net);
+
+	/** Sets the node budget of every search, instead of the fixed depth the search is deepened from one ply
+	* until the budget runs out (or the player's depth is reached), and the move of the last finished depth is played
+	* NOTE: the node count doesn't depend on the machine or its load, so the same budget gives the same moves everywhere
+	* @param nodes : The node budget, or 0 to search with the player's depth
+	*/
+	void SetNodeLimit(unsigned long long nodes);
+
+	/** Sets the flag, that stops the searches as soon as it is set (from any thread)
+	* The search is then deepened from one ply, so the stopped search returns the move of the last finished depth
+	* @param stop : The stop flag (not owned by the player), or nullptr to search without it
+	*/
+	void SetStopFlag(const std::atomic<bool> * stop);
+
+	/** Sets the listener of the search progress, the search is then deepened from one ply and reports every finished depth
+	* @param searchListener : The listener (not owned by the player), or nullptr to search without it
+	*/
+	void SetSearchListener(SearchListener * searchListener);
+
+	// Clears the transition table and the evaluation caches, so the next search doesn't depend on the previous ones
+	void NewGame();
+
+	// Replaces the evaluation cache with a new (empty) one with the specified count of entries
+	void SetEvalCacheSize(int size);
+
+	// Replaces the transition table with a new (empty) one with the specified count of entries
+	void SetTransitionTableSize(int size);
+
+	/** Replaces the own transition table with the table shared with other players, which may search with it at the same time
+	* NOTE: NewGame() and SetNetwork(...) clear the shared table for all of them
+	* @param table : The shared table (not owned by the player)
+	*/
+	void SetSharedTransitionTable(TransitionTable * table);
+
+	// Returns the counters of the last search
+	const SearchStats& GetSearchStats() const;
+
+	/** Starts the search of the best move with the player's search depth, which then runs in the steps of the StepSearch(...)
+	* so a single thread can keep doing other work (like rendering, or stepping other searches) while the player thinks
+	* NOTE: the search keeps its own copy of the board, any running stepped search is abandoned
+	*/
+	void BeginSearch(const Board& board, Config::PlayerColour colour) const;
+
+	/** Continues the search started by the BeginSearch(...)
+	* @param nodes : The count of the nodes searched in this step, or 0 to search until the end
+	* @retval : true if the search has finished (or no search is running)
+	*/
+	bool StepSearch(unsigned long long nodes) const;
+
+	// Returns the best move of the stepped search (of the last finished depth while it runs), with the score in its heuristic
+	Move GetSearchResult() const;
+
+	// Returns true while the search started by the BeginSearch(...) hasn't finished
+	bool IsSearching() const;
+
+	/** Thinks about the player's move in steps, like the GetMove(...) without blocking the caller for the whole search
+	* The first call (or a call with another board or player on move than the running search) starts the search anew
+	* @param nodes : The count of the nodes searched in this call, or 0 to search until the move is found
+	* @retval : true if the move was found and written to the piece and the pos
+	*/
+	bool ThinkMove(Piece& piece, ChessVector& pos, const Board * board, unsigned long long nodes) const;
+
 private:
 	/** Calculates all the best moves for the current player through AlphaBetaRoot. Afterwards it takes the square root of the number of
 	* best evaluated moves and evaluates them for the opposite player. It again takes the best evaluated enemy moves (square root) and for each of them
@@ -134,18 +544,69 @@ private:
 	*/
 	void AlphaBetaRoot(const Board& board, Config::PlayerColour colour, DynamicArray<Move>& generatedMoves) const;
 
-	Move AlphaBetaSingle(const Board& board, int depth, Config::PlayerColour colour) const;
+	/** Searches the root moves with the depth, or deepens the search to it with the node budget, the stop flag or the listener
+	* @param searchMoves : The root moves to be searched, or nullptr for all the moves
+	*/
+	Move AlphaBetaSingle(const Board& board, int depth, Config::PlayerColour colour, const DynamicArray<Move> * searchMoves = nullptr) const;
+
+	/** Prepares the stepped search of the root moves (restricted to the searchMoves if they are not nullptr) to the depth,
+	* the AlphaBetaSingle(...) is this search run to its end
+	*/
+	void StartSearch(const Board& board, int depth, Config::PlayerColour colour, const DynamicArray<Move> * searchMoves) const;
+
+	// Fills the root moves of the player, ordered by the move heuristic
+	void GetRootMoves(Board& board, Config::PlayerColour colour, DynamicArray<Move>& rootMoves) const;
+
+	/** Searches the root moves (in the ply 0 buffer of the move arena) from the firstMove and puts the best one in its place,
+	* with the score in its heuristic
+	* @retval : The score of the best move
+	*/
+	int SearchRoot(Board& board, int depth, Config::PlayerColour colour, int firstMove) const;
+
+	// Puts the root frame of the search to the depth on the bottom of the stack
+	void PushRootFrame(int depth, Config::PlayerColour colour, int firstMove) const;
+
+	/** Collects the principal variation of the move by following the best moves in the transition table
+	* @param maxLength : The maximum count of the moves in the variation
+	* @param pv[out] : The variation starting with the move
+	*/
+	void GetPrincipalVariation(Board& board, Config::PlayerColour colour, const Move& move, int maxLength, DynamicArray<Move>& pv) const;
+
+	/** Enters the node of the search: resolves it at once (a leaf, a draw, a cutoff, a mate, or the aborted search),
+	* or prepares its moves and its frame on the stack to be searched by the RunFrames(...)
+	* @param value[out] : The score of the resolved node
+	* @retval : true if the node was resolved, false if its frame was pushed
+	*/
+	bool EnterNode(Board& board, int depth, int ply, int alpha, int beta, Config::PlayerColour colour, int& value) const;
+
+	/** Searches the frames on the stack (instead of the recursion) until the base frame is finished or the node count
+	* reaches the stepEnd, the aborted search unwinds the whole stack down to the base frame
+	* @param top[in, out] : The ply of the topmost frame, where the search continues the next time
+	* @param value[out] : The score of the finished base frame
+	* @retval : true if the base frame is finished (or the search was aborted), false if the step ended
+	*/
+	bool RunFrames(Board& board, int base, int& top, unsigned long long stepEnd, int& value) const;
+
+	// Stores the result of the searched frame (in the transition table, or in the root moves for the root frame) and returns its score
+	int FinishFrame(const SearchFrame& frame, int ply) const;
 
-	/** The main algorithm for decision making of moves
+	/** The main algorithm for decision making of moves (negamax form, every score is for the player on move)
+	* NOTE: it runs the frames of the explicit stack to the end, see the RunFrames(...)
 	* @param board : The current board for which we search for best move
 	* @param depth : The current search depth
+	* @param ply : The distance from the root of the search (used for indexing the move arena and for the mate distance)
 	* @param alpha : The heuristic of the best found move to the moment
 	* @param beta : The hauristic of the best found enemy move for the moment
-	* @param maximizing : If this is a maximizin call or a minimizing one
 	* @param colour : The colour of the player that makes the move
-	* @retval : The best calculated heuristic
+	* @retval : The best calculated heuristic, MATE_SCORE - ply when the player gives mate in ply plies from the root
+	*/
+	int AlphaBeta(Board& board, int depth, int ply, int alpha, int beta, Config::PlayerColour colour) const;
+
+	/** The check only search of the FindMate(...)
+	* @param depth : The remaining plies, the attacker is on move when it is odd and the defender (in check) when it is even
+	* @retval : true if the attacker mates in the remaining plies whatever the defender does
 	*/
-	int AlphaBeta(Board& board, int depth, int alpha, int beta, bool maximizing, Config::PlayerColour colour) const;
+	bool MateSearch(Board& board, int depth, int ply, Config::PlayerColour colour) const;
 
 	/** makes some changes to the moves array taken from the AlphaBetaRoot or IteratingAlphaBeta and makes some
 	* adjustments so that it would pick easier
@@ -155,9 +616,38 @@ private:
 	// The main heuristic of move function
 	int MoveHeuristic(const Move& move, const Board& board) const;
 
+	/** Returns the evaluation of the board (positive for white), through the evaluation cache
+	* NOTE: it is the network evaluation if the board has a network, or the material balance together with the pawn structure otherwise
+	*/
+	int Evaluate(const Board& board) const;
+
 	RandomGenerator * rgen;
 
 	TransitionTable * transitionTable;
+	bool ownsTransitionTable; // false if the table is shared with other players
+
+	MoveArena * moveArena;
+
+	EvalCache * evalCache;
+
+	PawnHashTable * pawnHashTable;
+
+	SearchStats * searchStats;
+
+	// the explicit stack of the search, indexed by the ply
+	SearchFrame * frames;
+
+	SteppedSearch * stepped;
+
+	// the node budget of every search, 0 if the search has only the fixed depth
+	unsigned long long nodeLimit;
+
+	// not owned objects - no destruction
+	const std::atomic<bool> * stopFlag;
+	SearchListener * listener;
+	const OpeningBook * openingBook;
+	const Tablebases * tablebases;
+	const NnueNetwork * network;
 };
 
 #endif // __PLAYER_H__
\ No newline at end of file
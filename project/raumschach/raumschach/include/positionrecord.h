@@ -0,0 +1,98 @@
+#ifndef __POSITIONRECORD_H__
+#define __POSITIONRECORD_H__
+
+#include "configuration.h"
+#include "piece.h"
+#include <stdio.h>
+
+class Board;
+
+// The game result of a labeled position
+enum PositionResult
+{
+	RESULT_BLACK_WIN,
+	RESULT_DRAW,
+	RESULT_WHITE_WIN,
+};
+
+/** A single labeled position, used for the evaluation tuning. The positions file is the Config::POSITION_RECORD_MAGIC
+* followed by the records until the end of the file, so new records can be appended to it.
+* NOTE: the records are written in the native byte order, the pieces the same way as in the saved games
+*/
+struct PositionRecord
+{
+	Piece pieces[Config::POSITION_RECORD_MAX_PIECES]; // the pieces on the board, the unused ones have no type
+	unsigned char colourToMove;
+	unsigned char result; // PositionResult of the game the position is from
+	short score; // the search score of the position (positive for white), if it is known
+
+	// Stores the pieces of the board, returns false if the board has too many pieces
+	bool FromBoard(const Board& board, Config::PlayerColour toMove);
+	// Adds the stored pieces to the (cleared) board
+	void ToBoard(Board& board) const;
+
+	// Returns the result as a score from white's point of view (0 for a loss, 0.5 for a draw and 1 for a win)
+	inline float GetWhiteScore() const
+	{
+		return result * 0.5f;
+	}
+};
+
+// Reads the position records from a file in blocks, so the file doesn't have to fit in memory
+class PositionRecordReader
+{
+public:
+	PositionRecordReader();
+	~PositionRecordReader();
+
+	// Opens the file, returns false if it is missing or isn't a positions file
+	bool Open(const char * filename);
+	void Close();
+
+	/** Reads the next records
+	* @param records[out] : The buffer for the records
+	* @param count : The size of the buffer
+	* @retval : The count of the read records, 0 at the end of the file
+	*/
+	int Read(PositionRecord * records, int count);
+
+private:
+	// disable copy and assign
+	PositionRecordReader(const PositionRecordReader& copy);
+	PositionRecordReader& operator=(const PositionRecordReader& assign);
+
+	FILE * input;
+};
+
+// Writes the position records to a file through a buffer
+class PositionRecordWriter
+{
+public:
+	PositionRecordWriter();
+	~PositionRecordWriter();
+
+	/** Opens the file for writing
+	* @param filename : The positions file
+	* @param append : If the records are added to an existing positions file instead of creating a new one
+	* @retval : false if the file couldn't be opened (or isn't a positions file when appending)
+	*/
+	bool Open(const char * filename, bool append = false);
+	// Flushes the buffered records and closes the file
+	void Close();
+
+	void Write(const PositionRecord& record);
+
+	// Writes the buffered records to the file
+	bool Flush();
+
+private:
+	// disable copy and assign
+	PositionRecordWriter(const PositionRecordWriter& copy);
+	PositionRecordWriter& operator=(const PositionRecordWriter& assign);
+
+	FILE * output;
+	PositionRecord * buffer;
+	int bufferCount;
+};
+
+#endif // __POSITIONRECORD_H__
@@ -0,0 +1,101 @@
+#ifndef __PROOFSEARCH_H__
+#define __PROOFSEARCH_H__
+
+#include "board.h"
+#include <stdio.h>
+
+enum ProofResult
+{
+	PROOF_UNKNOWN, // the node table ran out before the root was solved
+	PROOF_PROVED, // the attacker mates
+	PROOF_DISPROVED, // the defender escapes every line of checks within the moves
+};
+
+// A position of the proof tree, reached by the move from its parent
+struct ProofNode
+{
+	unsigned proof; // the count of the leaves that must be proved to prove the node, 0 when proved
+	unsigned disproof; // the count of the leaves that must be disproved to disprove the node, 0 when disproved
+	int parent;
+	int firstChild;
+	int nextSibling; // the next child of the parent, or the next free node in the free list
+	coord source;
+	coord destination;
+	bool expanded;
+};
+
+/** Proof-number search of the forced mates (best-first, with the whole tree in a fixed node table)
+* The attacker (OR nodes) plays only the checks and the defender (AND nodes) all the evasions, the most proving leaf
+* is expanded every time. The subtrees of the solved nodes are returned to the table at once, only the proof stays.
+* NOTE: the found mate is not always the shortest one, every proved line of checks is a mate within the moves
+*/
+class ProofNumberSearch
+{
+public:
+	ProofNumberSearch(int nodeCount = Config::PROOF_SEARCH_NODES);
+	~ProofNumberSearch();
+
+	/** Searches for the forced mate of the player on move
+	* @param maxMoves : The longest searched mate in the moves of the attacker
+	* @retval : The result of the search, the proof stays in the node table until the next search
+	*/
+	ProofResult Solve(const Board& board, Config::PlayerColour colour, int maxMoves);
+
+	// Returns the first move of the proved mate (with the mate score in its heuristic), or an empty move
+	Move GetProofMove() const;
+
+	// Returns the count of the attacker moves in the longest line of the proof tree (the mate against the best defence)
+	int GetMateMoves() const;
+
+	// Writes the proof tree, every line is one move indented by its ply
+	void PrintProofTree(FILE * output) const;
+
+	// Returns the count of the expanded positions in the last search
+	unsigned long long GetExpandedCount() const;
+
+	// Returns the most nodes the table held at once in the last search
+	int GetPeakNodes() const;
+
+private:
+	// disable copy and assignment
+	ProofNumberSearch(const ProofNumberSearch& copy);
+	ProofNumberSearch& operator=(const ProofNumberSearch& assign);
+
+	// Takes a node from the free list, returns -1 if the table is full
+	int AllocateNode(int parent, coord source, coord destination);
+
+	// Returns the subtrees of the node's children to the free list
+	void FreeChildren(int node);
+
+	// Frees the children of the solved node, which are not a part of the proof
+	void CollectGarbage(int node, bool attacking);
+
+	/** Generates the children of the node, the checks of the attacker or the evasions of the defender
+	* @retval : false if the table is full
+	*/
+	bool Expand(int node, int ply, bool attacking);
+
+	// Recalculates the proof and disproof numbers of the expanded node from its children
+	void Update(int node, bool attacking);
+
+	// Returns the length of the longest line of the proof tree in plies
+	int GetProofDepth(int node) const;
+
+	void PrintNode(FILE * output, int node, int ply) const;
+
+	ProofNode * nodes;
+	int capacity;
+	int freeList;
+	int untouchedNodes; // the nodes from this one on were not used in the search yet
+	int usedNodes;
+	int peakNodes;
+
+	Board board; // the searched board, the moves of the selected path are made on it
+	Config::PlayerColour rootColour;
+	int maxPlies; // the last ply of the defender, who must be mated in it
+	unsigned long long expanded;
+	DynamicArray<Move> moves;
+	DynamicArray<Move> replies;
+};
+
+#endif // __PROOFSEARCH_H__
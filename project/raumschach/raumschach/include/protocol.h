@@ -0,0 +1,127 @@
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include "configuration.h"
+#include "board.h"
+#include "player.h"
+#include "random_generator.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+// The receiver of the protocol responses
+class ProtocolOutput
+{
+public:
+	virtual ~ProtocolOutput() {}
+
+	// Writes a single response line (without the line end), the lines are never written from two threads at once
+	virtual void WriteLine(const char * line) = 0;
+};
+
+/** The line based text protocol of the engine (similar to UCI), the positions and the moves are in the Notation
+* uci                                          - writes the engine name and the options followed by "uciok"
+* isready                                      - writes "readyok"
+* ucinewgame                                   - clears the search tables
+* setoption name Hash value <MB>               - the size of the transition table shared by the search threads
+* setoption name Threads value <count>         - the count of the search threads, the root moves are split between them
+* position startpos|<position> [moves <move>...] - sets the position and plays the moves from it
+* go [depth <plies>] [nodes <count>] [movetime <ms>] [infinite]
+*                                              - starts the search in the background, writes an "info" line after every
+*                                                finished depth and the "bestmove" line at its end (after "stop" or "quit"
+*                                                for the infinite search)
+* stop                                         - stops the search, its best move is written right away
+* quit                                         - stops the search and ends the protocol
+* NOTE: a new command (other than isready) stops the running search first
+*/
+class ProtocolEngine
+{
+public:
+	ProtocolEngine(ProtocolOutput * output);
+	~ProtocolEngine();
+
+	/** Handles the single command line
+	* @retval : false after the quit command, true otherwise
+	*/
+	bool HandleCommand(const char * line);
+
+	// Waits until the running search ends on its own (the infinite search is stopped) and writes its best move
+	void WaitForSearch();
+
+private:
+	// disable copy and assignment
+	ProtocolEngine(const ProtocolEngine& copy);
+	ProtocolEngine& operator=(const ProtocolEngine& assign);
+
+	// Forwards the finished depths of a search thread to the engine
+	class DepthListener : public SearchListener
+	{
+	public:
+		DepthListener(ProtocolEngine * engine, int worker) : engine(engine), worker(worker) {}
+
+		void OnDepthFinished(const SearchInfo& info)
+		{
+			engine->DepthFinished(worker, info);
+		}
+
+	private:
+		ProtocolEngine * engine;
+		int worker;
+	};
+
+	void SetPosition(const std::vector<const char *>& tokens);
+	void SetOption(const std::vector<const char *>& tokens);
+	void StartSearch(const std::vector<const char *>& tokens);
+
+	// Sets the stop flag and waits for the search thread
+	void StopSearch();
+
+	// Creates the searchers for the threads and their shared table with the current hash size
+	void CreateSearchers();
+	void DeleteSearchers();
+
+	// Sets the stop flag and wakes the search thread waiting for it
+	void SignalStop();
+
+	// The search thread, runs the workers until they end, the time runs out or the search is stopped
+	// (the infinite search writes its best move only when it is stopped)
+	void RunSearch(int depth, unsigned long long nodes, long long moveTime, bool infinite);
+	void RunWorker(int worker, int depth);
+
+	// Collects the depth of the worker, the depth is reported when all the workers have finished it
+	void DepthFinished(int worker, const SearchInfo& info);
+
+	void Write(const char * line);
+
+	ProtocolOutput * output;
+	std::mutex outputMutex;
+
+	BitBoardMovePool movePool;
+	Board board;
+	Config::PlayerColour colour;
+
+	int hashSize; // the transition table size in megabytes
+	int threadCount;
+	TransitionTable * transitionTable; // shared by all the searchers, so the workers use the results of each other
+	std::vector<AIPlayer *> searchers;
+	std::vector<RandomGenerator *> generators;
+	std::vector<DepthListener *> listeners;
+
+	// the state of the running search, the worker results are guarded by the searchMutex
+	std::thread searchThread;
+	std::atomic<bool> stopFlag;
+	bool infiniteSearch; // the running search writes its best move only when it is stopped
+	std::mutex searchMutex;
+	std::condition_variable workersFinished;
+	int runningWorkers;
+	int reportedDepth;
+	std::vector<DynamicArray<Move> > workerMoves; // the root moves of every worker
+	std::vector<std::vector<SearchInfo> > workerDepths; // the finished depths of every worker
+	std::vector<Move> workerBest;
+	std::chrono::steady_clock::time_point searchStart;
+};
+
+#endif // __PROTOCOL_H__
@@ -17,23 +17,23 @@ public:
 		generator.seed(s);
 	}
 
+	// NOTE: the standard distributions differ between the library implementations, so the ranges are mapped here
+	// from the raw generator output, which is the same everywhere (the same seed gives the same numbers on every machine)
+
 	// get the next random generated number
 	unsigned GetRand()
 	{
-		std::uniform_int_distribution<unsigned> gen;
-		return gen(generator);
+		return (unsigned) (generator() & 0xFFFFFFFFUL);
 	}
 	// get the next random generated number from [0..upperBound)
 	unsigned GetRand(unsigned upperBound)
 	{
-		std::uniform_int_distribution<unsigned> gen(0, upperBound - 1);
-		return gen(generator);
+		return (unsigned) (((unsigned long long) GetRand() * upperBound) >> 32);
 	}
 	// get the next random generated number from [a..b)
 	unsigned GetRand(unsigned a, unsigned b)
 	{
-		std::uniform_int_distribution<unsigned> gen(a, b - 1);
-		return gen(generator);
+		return a + GetRand(b - a);
 	}
 
 private:
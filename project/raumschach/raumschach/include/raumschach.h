@@ -11,6 +11,9 @@ class Render;
 class GraphicBoard;
 class RandomGenerator;
 class GraphicPanel;
+class OpeningBook;
+class Tablebases;
+class NnueNetwork;
 
 class Raumschach
 {
@@ -20,7 +23,9 @@ public:
 
 	// Initializes everything the chess needs to function
 	// this includes boards, move pools, renderers, textures, etc.
-	void Initialize();
+	// In the deterministic mode the random generator has a fixed seed and the ai players search with a fixed node budget,
+	// so the same games are played on every run and machine
+	void Initialize(bool deterministicMode = false);
 
 	// Main loop
 	void Start();
@@ -71,12 +76,17 @@ private:
 	BitBoardMovePool * movePool;
 	BoardTileState * tileState;
 	RandomGenerator * randGen;
+	OpeningBook * openingBook;
+	Tablebases * tablebases;
+	NnueNetwork * network;
 
+	// NOTE: the board keeps the hashes of the same moves, so the ai searches start with the whole game history
 	DynamicStack<MadeMove> moveStack;
 
 	bool gameEnded; // this is true if a checkmate or stalemate occured
 	bool triedMove; // if the current player already tried a move (it is valid only for ai players)
 	bool exitStatus; // true if the raumschach has to close
+	bool deterministic; // true if the games have to be reproducible (fixed seed and node budget)
 
 	Piece selectedPiece;
 	BitBoard selectedPieceMoves;
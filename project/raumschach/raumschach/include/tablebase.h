@@ -0,0 +1,181 @@
+#ifndef __TABLEBASE_H__
+#define __TABLEBASE_H__
+
+#include "configuration.h"
+#include "mappedfile.h"
+#include <unordered_map>
+
+class Board;
+
+/** The material of an endgame tablebase. The pieces are kept in canonical order: white king, black king,
+* the other white pieces and the other black pieces (sorted by type). The stronger side is always the white one,
+* so positions in which the black player is stronger are looked up with swapped colours.
+* NOTE: only pawnless materials are supported, so the colours can be swapped without changing the moves
+*/
+class TablebaseMaterial
+{
+public:
+	TablebaseMaterial();
+
+	// parses a signature like "KQvKR", returns false if it isn't a valid pawnless material
+	bool FromSignature(const char * signature);
+
+	/** Takes the material of the board
+	* @param board : The board which material is taken
+	* @param swapColours[out] : true if the colours of the board have to be swapped to match the canonical material
+	* @retval : false if the board can't be in a tablebase (too many pieces, pawns, missing kings)
+	*/
+	bool FromBoard(const Board& board, bool& swapColours);
+
+	// writes the signature of the material to dest (with size of at least TABLEBASE_MAX_SIGNATURE)
+	void GetSignature(char * dest) const;
+
+	// returns an unique key of the material
+	unsigned GetKey() const;
+
+	int GetPieceCount() const;
+	Config::PieceType GetType(int slot) const;
+	Config::PlayerColour GetColour(int slot) const;
+
+	/** Returns the count of positions in the table (both players on move)
+	* The white king is only in the tiles of its region, the positions with the white king elsewhere are indexed
+	* after the symmetry of the cube, which moves it to the region. The pieces of the same type and colour are indexed
+	* as a combination of their tiles, so every order of them has the same index.
+	*/
+	unsigned long long GetEntryCount() const;
+
+	// returns true if the game rules declare this material for stalemate (see Board::PieceStalemate)
+	bool IsDrawnByMaterial() const;
+
+	// returns the material without the piece in the specified slot (kings can't be removed)
+	TablebaseMaterial RemovePiece(int slot) const;
+
+	// returns the index of the board position (the board must have this material), all the symmetric positions have the same index
+	unsigned long long GetIndex(const Board& board, Config::PlayerColour colourToMove, bool swapColours) const;
+
+	/** Sets up the board with the position of the index
+	* @retval : false if pieces overlap, in which case the board is left in unspecified state
+	* NOTE: the board position may have another index, if the index isn't the smallest one of the symmetric positions
+	*/
+	bool SetupBoard(unsigned long long index, Board& board, Config::PlayerColour& colourToMove) const;
+
+private:
+	// sorts the pieces and swaps the colours if needed, returns true if the colours were swapped
+	bool Canonicalize();
+
+	// returns the slot after the last one of the pieces with the same type and colour as the piece in the first slot
+	int GetGroupEnd(int first) const;
+
+	// returns the index of the position with the tiles of the slots moved by the symmetry
+	unsigned long long GetSymmetricIndex(const int squares[], unsigned long long colourIndex, int symmetry) const;
+
+	int pieceCount;
+	unsigned char types[Config::TABLEBASE_MAX_PIECES];
+	unsigned char colours[Config::TABLEBASE_MAX_PIECES];
+};
+
+// The header of the tablebase file, followed by a byte value for every position index
+struct TablebaseHeader
+{
+	char magic[8];
+	char signature[Config::TABLEBASE_MAX_SIGNATURE];
+	unsigned long long entryCount;
+};
+
+// A single memory mapped distance to mate table
+class Tablebase
+{
+public:
+	Tablebase();
+
+	bool Open(const char * filename);
+
+	const TablebaseMaterial& GetMaterial() const;
+
+	inline unsigned char GetValue(unsigned long long index) const
+	{
+		return (index < entryCount ? values[index] : Config::TABLEBASE_INVALID);
+	}
+
+private:
+	// disable copy and assign
+	Tablebase(const Tablebase& copy);
+	Tablebase& operator=(const Tablebase& assign);
+
+	MappedFile file;
+	TablebaseMaterial material;
+	const unsigned char * values;
+	unsigned long long entryCount;
+};
+
+/** The set of all loaded tablebases
+* The position values are the distance to mate in plies plus one for the player on move (odd distances are wins,
+* even ones are losses), 0 for draws and 255 for impossible positions.
+*/
+class Tablebases
+{
+public:
+	Tablebases();
+	~Tablebases();
+
+	// tries to load the tables of all the pawnless materials up to TABLEBASE_MAX_PIECES, returns the count of loaded tables
+	int Load(const char * directory);
+
+	// loads a single table file
+	bool AddTable(const char * filename);
+
+	int GetTableCount() const;
+
+	// returns true if the table of the material is loaded
+	bool HasTable(const TablebaseMaterial& material) const;
+
+	// returns the maximum count of pieces in the loaded tables
+	int GetMaxPieces() const;
+
+	/** Looks up the value of the board position
+	* @retval : false if there is no table for the board material
+	* NOTE: materials which are draws by the game rules are always found
+	*/
+	bool ProbeValue(const Board& board, Config::PlayerColour colourToMove, unsigned char& value) const;
+
+	/** Looks up the board position and converts the result to a search score
+	* @param score[out] : The score for the player on move (positive when winning, closer mates score higher)
+	* @retval : false if there is no table for the board material
+	*/
+	bool Probe(const Board& board, Config::PlayerColour colourToMove, int& score) const;
+
+	// returns true if the value is a win for the player on move
+	static inline bool IsWin(unsigned char value)
+	{
+		return value != Config::TABLEBASE_DRAW && value != Config::TABLEBASE_INVALID && ((value - 1) & 1) != 0;
+	}
+
+	// returns true if the value is a loss for the player on move
+	static inline bool IsLoss(unsigned char value)
+	{
+		return value != Config::TABLEBASE_DRAW && value != Config::TABLEBASE_INVALID && ((value - 1) & 1) == 0;
+	}
+
+	static inline int GetDistanceToMate(unsigned char value)
+	{
+		return value - 1;
+	}
+
+	static inline unsigned char MakeValue(int distanceToMate)
+	{
+		return (unsigned char) (distanceToMate + 1);
+	}
+
+	// returns the file name of the table for the material (in the specified directory)
+	static void GetFilename(const TablebaseMaterial& material, const char * directory, char * dest, int destSize);
+
+private:
+	// disable copy and assign
+	Tablebases(const Tablebases& copy);
+	Tablebases& operator=(const Tablebases& assign);
+
+	std::unordered_map<unsigned, Tablebase *> tables;
+	int maxPieces;
+};
+
+#endif // __TABLEBASE_H__
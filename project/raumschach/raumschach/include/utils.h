@@ -3,6 +3,10 @@
 
 #include "configuration.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define	COUNT_OF(x) sizeof((x)) / sizeof((x[0]))
 
 namespace Utils
@@ -29,6 +33,26 @@ namespace Utils
 
 	const unsigned char BITBOARD_PHYS_SIZE_OFFSET = 6; // for division with right shifts
 	const unsigned char BITBOARD_PHYS_SIZE_MOD_MASK = 0x40 - 1; // for modulo with bit operations
+
+	// returns the count of the leading zero bits of a non-zero value
+	inline unsigned char LeadingZeros(unsigned long long value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, value);
+		return (unsigned char) (BITBOARD_PHYS_SIZE - 1 - index);
+#elif defined(__GNUC__)
+		return (unsigned char) __builtin_clzll(value);
+#else
+		unsigned char count = 0;
+		while(!(value & 0x8000000000000000ULL))
+		{
+			value <<= 1;
+			++count;
+		}
+		return count;
+#endif
+	}
 };
 
 template< class Type >
@@ -235,6 +259,12 @@ protected:
 template<class Type>
 class DynamicStack : protected DynamicArray<Type>
 {
+	// the members of the dependent base class have to be named to be found by the standard two phase lookup
+	using DynamicArray<Type>::arr;
+	using DynamicArray<Type>::size;
+	using DynamicArray<Type>::count;
+	using DynamicArray<Type>::Realloc;
+
 public:
 	DynamicStack(int stackSize = 40) : DynamicArray<Type>(stackSize) {}
 
@@ -242,7 +272,7 @@ public:
 
 	DynamicStack(const DynamicStack<Type>& copy) : DynamicArray<Type>(copy) {}
 
-	DynamicStack<Type>& operator=(const DynamicStack<Type>& assing)
+	DynamicStack<Type>& operator=(const DynamicStack<Type>& assign)
 	{
 		if(this != &assign)
 		{
@@ -600,6 +630,25 @@ public:
 		return BitCount(bits[0]) + BitCount(bits[1]);
 	}
 
+	// clears the first set bit and returns its coord, or -1 if there are no bits set
+	// NOTE: this allows iterating the bits without filling a DynamicArray of vectors
+	inline coord PopFirstBit()
+	{
+		if(bits[0])
+		{
+			const unsigned char offset = Utils::LeadingZeros(bits[0]);
+			bits[0] &= ~ (Config::BITBOARD_BIT >> offset);
+			return (coord) offset;
+		}
+		if(bits[1])
+		{
+			const unsigned char offset = Utils::LeadingZeros(bits[1]);
+			bits[1] &= ~ (Config::BITBOARD_BIT >> offset);
+			return (coord) (Utils::BITBOARD_PHYS_SIZE + offset);
+		}
+		return -1;
+	}
+
 	// sets all bits to proper vectors in the specified DynamicArray
 	inline void GetVectors(DynamicArray<ChessVector>& dest) const
 	{
@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "notation.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <chrono>
+
+namespace
+{
+	// the positions of the benchmark, from the opening to the endgame
+	const char * const BENCH_POSITIONS[] =
+	{
+		"w RAa1 NAb1 KAc1 NAd1 RAe1 PAa2 PAb2 PAc2 PAd2 PAe2 BBa1 UBb1 QBc1 BBd1 UBe1 PBa2 PBb2 PBc2 PBd2 PBe2 pDa4 pDb4 pDc4 pDd4 pDe4 bDa5 uDb5 qDc5 bDd5 uDe5 pEa4 pEb4 pEc4 pEd4 pEe4 rEa5 nEb5 kEc5 nEd5 rEe5",
+		"w RAa1 KAc1 RAe1 PAb2 PAc2 PAd2 PAe2 BBa1 UBb1 BBd1 UBe1 PBa2 PBb2 PBc2 PBd2 PBe2 PBa3 QCc1 pCb4 pDa4 kDb4 pDc4 pDd4 pDe4 bDa5 uDb5 bDd5 uDe5 NEa2 pEa4 pEb4 pEc4 pEd4 pEe4 rEa5 nEd5 rEe5",
+		"w qAa1 NAb1 NAd1 RAe1 PAa2 PAb2 PAc2 PAd2 PAe2 UBe1 PBa2 PBb2 PBc2 PBd2 PBe2 BCb1 QCd1 KCb2 UCc2 bCa4 pDa4 pDb4 pDc4 pDd4 pDe4 uDb5 bDd5 uDe5 BEa1 pEa4 pEb4 pEc4 pEd4 pEe4 rEa5 nEb5 kEc5 nEd5 rEe5",
+		"w RAa1 NAb1 NAd1 RAe1 PAb2 PAc2 PAd2 PAe2 PAa3 KAd4 BBa1 PBa2 PBb2 PBe2 PBd4 bBb5 QCd1 pDc3 pDe3 pDa4 pDc4 nDe4 bDa5 uDb5 uDe5 BEa1 qEd2 pEd3 pEa4 pEb4 UEe4 rEa5 kEc5 rEd5",
+		"w NAb1 NAd1 bAa2 PAb2 PAc2 PAd2 PAe2 RBe1 PBa2 PBc2 PBd2 PBe2 QBb4 BCb1 KCb2 PCc2 kCd4 pDd3 pDa4 pDb4 pDe4 uDb5 bDd5 uDe5 qEa1 pEc3 pEa4 pEd4 pEe4 rEa5 nEb5 nEd5 rEe5",
+		"w RAa1 PAc2 PAd2 RAe2 KAb4 BBa1 UBb1 BBd1 UBe1 PBa2 PBc2 PBd2 PBe2 rBa5 PCb2 pCb4 kDd2 pDc3 pDa4 pDd4 pDe4 nDb5 NEa2 pEa4 pEb4 pEc4 pEd4 pEe4 QEe5",
+		"w RAd1 PAc2 PAd2 RAe2 KAd5 BBa1 UBe1 rBa2 PBc2 PBd2 pBb4 PCb2 PCe2 pCd4 pDc3 pDa4 pDb4 pDe4 NEa2 kEc2 pEa4 pEc4 UEe4 BEe5",
+		"w PAc2 PAd2 RAe2 UBb1 UBe1 PBd2 KBb3 PCb2 PCe2 PCc3 NCd4 kDd1 pDb4 BDe4 pEc3 rEa4",
+		"w PAc2 PAd2 RAe5 UBb1 UBe1 PBd2 KBb3 PCe2 kDc1 pDb2 QDd4 BDe4 NDa5 rEa1",
+		"b KAc1 PBd2 QCa2 qDa4 pDb4 kEc5",
+		"w KAc1 RBb2 PBc2 kEc5",
+	};
+}
+
+unsigned long long Bench::Run(int depth)
+{
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	RandomGenerator rgen(Config::DETERMINISTIC_SEED);
+	AIPlayer searcher(depth, 0, Config::WHITE, &rgen);
+
+	unsigned long long totalNodes = 0ULL;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for(int i = 0; i < COUNT_OF(BENCH_POSITIONS); ++i)
+	{
+		DynamicArray<Piece> pieces;
+		Config::PlayerColour colour = Config::WHITE;
+		if(!Notation::ParsePosition(BENCH_POSITIONS[i], pieces, colour))
+		{
+			printf("Position %d is not valid\n", i + 1);
+			continue;
+		}
+
+		// every position is searched with empty tables, so the node count doesn't depend on the previous positions
+		Board board(pieces, &movePool);
+		searcher.NewGame();
+		const Move best = searcher.Search(board, colour);
+		const unsigned long long nodes = searcher.GetSearchStats().nodes;
+		totalNodes += nodes;
+
+		char move[Notation::MOVE_LENGTH + 1];
+		Notation::FormatMove(best, move);
+		printf("Position %2d: %s, score %d, nodes %llu\n", i + 1, move, best.heuristic, nodes);
+	}
+
+	const long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("===========================\n");
+	printf("Total time (ms) : %lld\n", milliseconds);
+	printf("Nodes searched  : %llu\n", totalNodes);
+	printf("Nodes/second    : %llu\n", totalNodes * 1000ULL / (unsigned long long) Utils::Max(milliseconds, 1LL));
+	return totalNodes;
+}
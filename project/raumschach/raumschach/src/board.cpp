@@ -3,6 +3,8 @@
 #include "utils.h"
 #include "board.h"
 #include "random_generator.h"
+#include <assert.h>
+#include <string.h>
 
 BitBoardMovePool::BitBoardMovePool()
 {
@@ -14,6 +16,11 @@ BitBoardMovePool::BitBoardMovePool()
 	{
 		pawnCapturePool[i] = new BitBoard[Config::BOARD_SIZE];
 	}
+	for(int i = 0; i < COUNT_OF(pawnFrontSpanPool); ++i)
+	{
+		pawnFrontSpanPool[i] = new BitBoard[Config::BOARD_SIZE];
+	}
+	adjacentFilesPool = new BitBoard[Config::BOARD_SIZE];
 	for(int i = 0; i < COUNT_OF(hashTable); ++i)
 	{
 		hashTable[i] = new unsigned long long[Config::BOARD_SIZE];
@@ -32,6 +39,13 @@ BitBoardMovePool::~BitBoardMovePool()
 		delete[] pawnCapturePool[i];
 		pawnCapturePool[i] = nullptr;
 	}
+	for(int i = 0; i < COUNT_OF(pawnFrontSpanPool); ++i)
+	{
+		delete[] pawnFrontSpanPool[i];
+		pawnFrontSpanPool[i] = nullptr;
+	}
+	delete[] adjacentFilesPool;
+	adjacentFilesPool = nullptr;
 	for(int i = 0; i < COUNT_OF(hashTable); ++i)
 	{
 		delete[] hashTable[i];
@@ -39,7 +53,7 @@ BitBoardMovePool::~BitBoardMovePool()
 	}
 }
 
-void BitBoardMovePool::Initalize(RandomGenerator * randGen)
+void BitBoardMovePool::Initalize()
 {
 	const int boardSize = Config::BOARD_SIZE;
 	auto initPieceMoves = [boardSize] (BitBoard * dest, const coord srcVectors[][3], int srcVectorSize, bool scaleable)
@@ -64,6 +78,29 @@ void BitBoardMovePool::Initalize(RandomGenerator * randGen)
 	initPieceMoves( pawnCapturePool[Config::WHITE], Const::PAWN_CAPTURE_VECTORS_WHITE, VECTORS_COUNT(Const::PAWN_CAPTURE_VECTORS_WHITE), Const::PIECE_MOVE_SCALING[Config::PAWN]);
 	initPieceMoves( pawnCapturePool[Config::BLACK], Const::PAWN_CAPTURE_VECTORS_BLACK, VECTORS_COUNT(Const::PAWN_CAPTURE_VECTORS_BLACK), Const::PIECE_MOVE_SCALING[Config::PAWN]);
 
+	// initialize the pawn structure pools
+	for(coord pos = 0; pos < Config::BOARD_SIZE; ++pos)
+	{
+		const ChessVector pawnPos(pos);
+		pawnFrontSpanPool[Config::WHITE][pos].Zero();
+		pawnFrontSpanPool[Config::BLACK][pos].Zero();
+		adjacentFilesPool[pos].Zero();
+		for(coord tile = 0; tile < Config::BOARD_SIZE; ++tile)
+		{
+			const ChessVector tilePos(tile);
+			if(tile == pos || Utils::Abs(tilePos.x - pawnPos.x) > 1)
+				continue;
+
+			// the white pawns move up in y and z, the black ones down
+			if(tilePos.y >= pawnPos.y && tilePos.z >= pawnPos.z)
+				pawnFrontSpanPool[Config::WHITE][pos].SetBit(true, tile);
+			if(tilePos.y <= pawnPos.y && tilePos.z <= pawnPos.z)
+				pawnFrontSpanPool[Config::BLACK][pos].SetBit(true, tile);
+			if(tilePos.x != pawnPos.x)
+				adjacentFilesPool[pos].SetBit(true, tile);
+		}
+	}
+
 	// initialize vector pool
 	auto initPieceVectors = [] (DynamicArray<ChessVector>& dest, const coord srcVectors[][3], int srcVectorSize)
 	{
@@ -82,25 +119,30 @@ void BitBoardMovePool::Initalize(RandomGenerator * randGen)
 	initPieceVectors( vectorPool[Config::PAWN + Config::WHITE], Const::PAWN_MOVE_VECTORS_WHITE, VECTORS_COUNT(Const::PAWN_MOVE_VECTORS_WHITE));
 	initPieceVectors( vectorPool[Config::PAWN + Config::BLACK], Const::PAWN_MOVE_VECTORS_BLACK, VECTORS_COUNT(Const::PAWN_MOVE_VECTORS_BLACK));
 
-	InitZobristHash(randGen);
+	InitZobristHash();
 }
 
-void BitBoardMovePool::InitZobristHash(RandomGenerator * randGen)
+void BitBoardMovePool::InitZobristHash()
 {
+	RandomGenerator randGen(Config::ZOBRIST_HASH_SEED);
 	unsigned long long randLow = 0UL;
 	unsigned long long randHigh = 0UL;
-	const unsigned UNSIGNED_MAX = ~0U;
 
 	for(int i = 0; i < COUNT_OF(hashTable); ++i)
 	{
 		for(int j = 0; j < Config::BOARD_SIZE; ++j)
 		{
-			randHigh = ((unsigned long long) randGen->GetRand(UNSIGNED_MAX)) << 32;
-			randLow = randGen->GetRand(UNSIGNED_MAX);
+			randHigh = ((unsigned long long) randGen.GetRand()) << 32;
+			randLow = randGen.GetRand();
 			hashTable[i][j] = randHigh | randLow;
 		}
 	}
 
+	// the white player on move doesn't change the hash
+	colourHashTable[Config::WHITE] = 0ULL;
+	randHigh = ((unsigned long long) randGen.GetRand()) << 32;
+	randLow = randGen.GetRand();
+	colourHashTable[Config::BLACK] = randHigh | randLow;
 }
 
 BitBoard BitBoardMovePool::CalculateBitBoard(ChessVector pos, const coord vectors[][3], int srcVectorSize, bool scaleable)
@@ -174,14 +216,12 @@ BitBoard BitBoardMovePool::GetPieceMoves(Piece p, const BitBoard& friendlyPieces
 		if(includeFriendly) tmp |= pool[pType][p.GetPositionCoord()] & friendlyPieces;
 		if(board)
 		{
-			DynamicArray<ChessVector> kingMoves;
-			tmp.GetVectors(kingMoves);
 			Config::PlayerColour oppositePlayer = Config::GetOppositePlayer(p.GetColour());
-			for(int i = 0; i < kingMoves.Count(); ++i)
+			for(coord kingMove = tmp.PopFirstBit(); kingMove >= 0; kingMove = tmp.PopFirstBit())
 			{
-				if(!board->TileThreatened(kingMoves[i], oppositePlayer))
+				if(!board->TileThreatened(ChessVector(kingMove), oppositePlayer))
 				{
-					result.SetBit(true, kingMoves[i].GetVectorCoord());
+					result.SetBit(true, kingMove);
 				}
 			}
 		}
@@ -195,21 +235,23 @@ BitBoard BitBoardMovePool::GetPieceMoves(Piece p, const BitBoard& friendlyPieces
 }
 
 Board::Board()
-	: movePool(nullptr)
+	: movePool(nullptr), materialScore(0), hash(0ULL), pawnHash(0ULL), hashHistory(Config::HASH_HISTORY_SIZE), reversiblePlies(0), network(nullptr)
 {
 	piecesBitBoards[Config::WHITE] = BitBoard(0ULL, 0ULL);
 	piecesBitBoards[Config::BLACK] = BitBoard(0ULL, 0ULL);
+	SetNetwork(nullptr);
 }
 
 Board::Board(BitBoardMovePool * pool)
-	: movePool(pool)
+	: movePool(pool), materialScore(0), hash(0ULL), pawnHash(0ULL), hashHistory(Config::HASH_HISTORY_SIZE), reversiblePlies(0), network(nullptr)
 {
 	piecesBitBoards[Config::WHITE] = BitBoard(0ULL, 0ULL);
 	piecesBitBoards[Config::BLACK] = BitBoard(0ULL, 0ULL);
+	SetNetwork(nullptr);
 }
 
 Board::Board(const DynamicArray< Piece >& pieceArray, BitBoardMovePool * pool)
-	: movePool(pool)
+	: movePool(pool), materialScore(0), hash(0ULL), pawnHash(0ULL), hashHistory(Config::HASH_HISTORY_SIZE), reversiblePlies(0), network(nullptr)
 {
 	for(int i = 0; i < pieceArray.Count(); ++i)
 	{
@@ -225,11 +267,21 @@ Board::Board(const DynamicArray< Piece >& pieceArray, BitBoardMovePool * pool)
 	{
 		piecesBitBoards[Config::BLACK].SetBit(true, pieces[Config::BLACK][i].GetPositionCoord());
 	}
+
+	materialScore = CalculateMaterialScore();
+	hash = CalculateHash();
+	pawnHash = CalculateHash(true);
+	SetNetwork(nullptr);
 }
 
 Board::Board(const Board& copy)
-	: movePool(copy.movePool)
+	: movePool(copy.movePool), materialScore(copy.materialScore), hash(copy.hash), pawnHash(copy.pawnHash), hashHistory(copy.hashHistory), reversiblePlies(copy.reversiblePlies), network(copy.network), accumulator(copy.accumulator)
 {
+	for(int i = 0; i < Config::PCOLOUR_COUNT; ++i)
+	{
+		accumulatorKingBuckets[i] = copy.accumulatorKingBuckets[i];
+		accumulatorDirty[i] = copy.accumulatorDirty[i];
+	}
 	pieces[Config::WHITE] = copy.pieces[Config::WHITE];
 	pieces[Config::BLACK] = copy.pieces[Config::BLACK];
 	piecesBitBoards[Config::WHITE] = copy.piecesBitBoards[Config::WHITE];
@@ -245,6 +297,18 @@ Board& Board::operator=(const Board& assign)
 		movePool = assign.movePool;
 		piecesBitBoards[Config::WHITE] = assign.piecesBitBoards[Config::WHITE];
 		piecesBitBoards[Config::BLACK] = assign.piecesBitBoards[Config::BLACK];
+		materialScore = assign.materialScore;
+		hash = assign.hash;
+		pawnHash = assign.pawnHash;
+		hashHistory = assign.hashHistory;
+		reversiblePlies = assign.reversiblePlies;
+		network = assign.network;
+		accumulator = assign.accumulator;
+		for(int i = 0; i < Config::PCOLOUR_COUNT; ++i)
+		{
+			accumulatorKingBuckets[i] = assign.accumulatorKingBuckets[i];
+			accumulatorDirty[i] = assign.accumulatorDirty[i];
+		}
 	}
 	return *this;
 }
@@ -258,21 +322,21 @@ void Board::GetPossibleMoves(Config::PlayerColour colour, DynamicArray<Move>& mo
 	BitBoard enemyPieces = GetPiecesBitBoard(Config::GetOppositePlayer(colour));
 
 	// then create a move for each piece
+	// NOTE: the destinations are taken directly from the bits, so nothing is allocated here
+	// as long as the moveArray has enough space (the search provides preallocated ones)
 	for(int i = 0; i < validPieces.Count(); ++i)
 	{
-		DynamicArray<ChessVector> destinations(Const::PIECE_MAX_MOVE_COUNT[validPieces[i].GetType()]);
-
-		BitBoard availableMoves = movePool->GetPieceMoves(validPieces[i], friendlyPieces, enemyPieces, this);
-		availableMoves.GetVectors(destinations);
+		const BitBoard availableMoves = movePool->GetPieceMoves(validPieces[i], friendlyPieces, enemyPieces, this);
+		BitBoard destinations(availableMoves);
 
 		// now for every possible move, push an object to the moveArray
-		for(int j = 0; j < destinations.Count(); ++j)
+		for(coord destination = destinations.PopFirstBit(); destination >= 0; destination = destinations.PopFirstBit())
 		{
 			// add the destination to the possible moves only if it is valid
 			// this saves us several computations later and is assuring that
 			// this are all valid moves that can be made
-			if(ValidMove(validPieces[i], destinations[j], availableMoves))
-				moveArray += Move(validPieces[i], destinations[j], availableMoves);
+			if(ValidMove(validPieces[i], ChessVector(destination), availableMoves))
+				moveArray += Move(validPieces[i], ChessVector(destination), availableMoves);
 		}
 	}
 }
@@ -341,32 +405,50 @@ MadeMove Board::MovePiece(Piece piece, ChessVector pos, const BitBoard& availabl
 			removedPiece = pieces[oppositeColour][destinationIndex];
 		}
 		move = MadeMove(removedPiece, piece.GetPositionVector());
+		move.reversiblePlies = reversiblePlies;
+
+		// captures and pawn moves can't be undone by the players, so the previous positions can't repeat anymore
+		hashHistory += hash;
+		reversiblePlies = (destinationIndex >= 0 || piece.GetType() == Config::PAWN ? 0 : reversiblePlies + 1);
 
 		// do the actual move
+		Piece& movedPiece = pieces[pieceColour][pieceIndex];
+		materialScore -= GetPieceScore(movedPiece);
+		TogglePieceHash(movedPiece);
+		UpdateAccumulator(movedPiece, false, true);
 
 		// update piece bit boards
 		piecesBitBoards[pieceColour].SetBit(false, piece.GetPositionCoord());
 		piecesBitBoards[pieceColour].SetBit(true, pos.GetVectorCoord());
 
 		// set the new position of the piece
-		pieces[piece.GetColour()][pieceIndex].SetPositionVector(pos);
-
+		movedPiece.SetPositionVector(pos);
 
 		// if the piece is a pawn and has reached the ending tile, it is considered to become a queen
-		if(pieces[pieceColour][pieceIndex].GetType() == Config::PAWN
+		if(movedPiece.GetType() == Config::PAWN
 			&& Const::PAWN_REPRODUCE_VECTORS[pieceColour].y == pos.y
 			&& Const::PAWN_REPRODUCE_VECTORS[pieceColour].z == pos.z)
 		{
-			pieces[pieceColour][pieceIndex].SetType(Config::QUEEN);
+			movedPiece.SetType(Config::QUEEN);
+			move.promoted = true;
 		}
 
+		materialScore += GetPieceScore(movedPiece);
+		TogglePieceHash(movedPiece);
+		UpdateAccumulator(movedPiece, true, true);
+
 		if(destinationIndex >= 0)
 		{
 			// update the bit boards
 			piecesBitBoards[oppositeColour].SetBit(false, pos.GetVectorCoord());
 
+			materialScore -= GetPieceScore(removedPiece);
+			TogglePieceHash(removedPiece);
+			UpdateAccumulator(removedPiece, false);
 			pieces[oppositeColour].RemoveItem(destinationIndex);
 		}
+
+		RefreshDirtyAccumulators();
 	}
 
 	return move;
@@ -383,11 +465,28 @@ void Board::UndoMove(const MadeMove& move)
 	{
 		// update bit boards
 		Piece& p = pieces[oppositeColour][pieceIndex];
+		materialScore -= GetPieceScore(p);
+		TogglePieceHash(p);
+		UpdateAccumulator(p, false, true);
 
 		piecesBitBoards[oppositeColour].SetBit(false, p.GetPositionCoord());
 		piecesBitBoards[oppositeColour].SetBit(true, move.sourcePosition.GetVectorCoord());
 
 		p.SetPositionVector(move.sourcePosition);
+		// a promoted queen goes back as the pawn it was
+		if(move.promoted)
+		{
+			p.SetType(Config::PAWN);
+		}
+		materialScore += GetPieceScore(p);
+		TogglePieceHash(p);
+		UpdateAccumulator(p, true, true);
+
+		reversiblePlies = move.reversiblePlies;
+		if(hashHistory.Count() > 0)
+		{
+			hashHistory.RemoveItem(hashHistory.Count() - 1);
+		}
 	}
 
 	// now if this wasn't a quiet move, we must add back the removed piece
@@ -395,6 +494,8 @@ void Board::UndoMove(const MadeMove& move)
 	{
 		AddPiece(move.removedPiece);
 	}
+
+	RefreshDirtyAccumulators();
 }
 
 bool Board::KingInCheck(Config::PlayerColour colour) const
@@ -447,60 +548,128 @@ Config::KingState Board::KingCheckState(Config::PlayerColour colour)
 		return Config::NO_KING;
 	}
 
-	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
-	BitBoard friendlyPiecesBitBoard = GetPiecesBitBoard(colour);
-	BitBoard enemyPiecesBitBoard = GetPiecesBitBoard(oppositeColour);
-
-	BitBoard kingMoves = movePool->GetPieceMoves( king, friendlyPiecesBitBoard, enemyPiecesBitBoard, this);
-	DynamicArray<ChessVector> kingMovesArray;
-	kingMoves.GetVectors(kingMovesArray);
-
-	bool hasMoveableTile = false;
-	// for every moveable tile, check if it isn't under check
-	for(int i = 0; i < kingMovesArray.Count() && !hasMoveableTile; ++i)
+	// the stalemate by pieces is checked only when the player can still move
+	const bool hasMove = HasLegalMove(colour);
+	if(!hasMove)
 	{
-		hasMoveableTile |= ! TileThreatened(kingMovesArray[i], oppositeColour);
+		kingState = (kingState == KingState::CHECK ? KingState::CHECKMATE : KingState::STALEMATE);
 	}
+	else if(PieceStalemate())
+	{
+		kingState = KingState::STALEMATE;
+	}
+
+	return kingState;
+}
+
+bool Board::HasLegalMove(Config::PlayerColour colour)
+{
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	const BitBoard friendlyPieces = GetPiecesBitBoard(colour);
+	const BitBoard enemyPieces = GetPiecesBitBoard(oppositeColour);
+	const Piece king = GetKing(colour);
 
-	// if the king has no moveable tiles, we must check the other figures
-	// this is slow operation, but will be rarely encountered
-	if(!hasMoveableTile)
+	// without the king no move can be illegal
+	if(king.GetType() != Config::KING)
 	{
-		const DynamicArray<Piece>& friendlyPieces = pieces[colour];
-		bool foundMove = false;
-		// check every piece for available moves, until at least one available move is found
-		for(int i = 0; i < friendlyPieces.Count() && !foundMove; ++i)
+		for(int i = 0; i < pieces[colour].Count(); ++i)
 		{
-			if(friendlyPieces[i].GetType() == Config::KING) continue;
+			if(movePool->GetPieceMoves(pieces[colour][i], friendlyPieces, enemyPieces, this))
+				return true;
+		}
+		return false;
+	}
 
-			BitBoard pieceMovesBitBoard = movePool->GetPieceMoves(friendlyPieces[i], friendlyPiecesBitBoard, enemyPiecesBitBoard, this);
+	// find the pieces giving the check and the pinned ones, the same way as TileThreatened(...) sees them
+	const ChessVector kingPos = king.GetPositionVector();
+	const BitBoard kingBitBoard(kingPos);
+	BitBoard checkMask; // the tiles, on which the non king pieces can stop the check
+	BitBoard pinned;
+	int checkers = 0;
+	for(int i = 0; i < pieces[oppositeColour].Count(); ++i)
+	{
+		const Piece& enemy = pieces[oppositeColour][i];
+		if(!(movePool->GetPieceFullMoves(enemy) & kingBitBoard))
+			continue;
 
-			DynamicArray<ChessVector> currentPieceMoves;
-			pieceMovesBitBoard.GetVectors(currentPieceMoves);
+		const ChessVector enemyPos = enemy.GetPositionVector();
+		if(!Const::PIECE_MOVE_SCALING[enemy.GetType()])
+		{
+			checkers++;
+			checkMask |= BitBoard(enemyPos);
+			continue;
+		}
 
-			for(int move = 0; move < currentPieceMoves.Count() && !foundMove; ++move)
+		// the scaling piece sees the king along a line, the pieces between decide between a check and a pin
+		const int delta[3] = {kingPos.x - enemyPos.x, kingPos.y - enemyPos.y, kingPos.z - enemyPos.z};
+		const int length = Utils::Max(Utils::Abs(delta[0]), Utils::Max(Utils::Abs(delta[1]), Utils::Abs(delta[2])));
+		BitBoard line(enemyPos);
+		int friendlyBlockers = 0;
+		int enemyBlockers = 0;
+		coord blocker = -1;
+		for(int step = 1; step < length; ++step)
+		{
+			const ChessVector tile(enemyPos.x + delta[0] / length * step, enemyPos.y + delta[1] / length * step, enemyPos.z + delta[2] / length * step);
+			const coord tileCoord = tile.GetVectorCoord();
+			line.SetBit(true, tileCoord);
+			if(friendlyPieces.GetBit(tileCoord))
+			{
+				friendlyBlockers++;
+				blocker = tileCoord;
+			}
+			else if(enemyPieces.GetBit(tileCoord))
 			{
-				foundMove |= ValidMove(friendlyPieces[i], currentPieceMoves[move], pieceMovesBitBoard);
+				enemyBlockers++;
 			}
 		}
 
-		// if no moves were found, then this is STALEMATE
-		if((kingState != KingState::CHECK && !foundMove))
+		if(friendlyBlockers == 0 && enemyBlockers == 0)
 		{
-			kingState = KingState::STALEMATE;
+			checkers++;
+			checkMask |= line;
 		}
-		else if(!foundMove && kingState == KingState::CHECK) // if no moves were found and the king is under a check, this is a checkmate
+		else if(friendlyBlockers == 1 && enemyBlockers == 0)
 		{
-			kingState = KingState::CHECKMATE;
+			pinned.SetBit(true, blocker);
 		}
-
 	}
-	else if(PieceStalemate())
+
+	// only the king can escape the double check
+	if(checkers < 2)
 	{
-		kingState = KingState::STALEMATE;
+		for(int i = 0; i < pieces[colour].Count(); ++i)
+		{
+			const Piece piece = pieces[colour][i];
+			if(piece.GetType() == Config::KING)
+				continue;
+
+			const BitBoard pieceMoves = movePool->GetPieceMoves(piece, friendlyPieces, enemyPieces, this);
+			if(!pieceMoves)
+				continue;
+
+			// a free piece can't uncover the king, so any of its moves is legal when there is no check
+			const bool isPinned = pinned.GetBit(piece.GetPositionCoord());
+			if(checkers == 0 && !isPinned)
+				return true;
+
+			BitBoard candidates(checkers > 0 ? pieceMoves & checkMask : pieceMoves);
+			for(coord destination = candidates.PopFirstBit(); destination >= 0; destination = candidates.PopFirstBit())
+			{
+				if(ValidMove(piece, ChessVector(destination), pieceMoves))
+					return true;
+			}
+		}
 	}
 
-	return kingState;
+	// the king moves are tested by making them, so the attacks through its current tile are seen too
+	const BitBoard kingMoves = movePool->GetPieceMoves(king, friendlyPieces, enemyPieces, this);
+	BitBoard destinations(kingMoves);
+	for(coord destination = destinations.PopFirstBit(); destination >= 0; destination = destinations.PopFirstBit())
+	{
+		if(ValidMove(king, ChessVector(destination), kingMoves))
+			return true;
+	}
+	return false;
 }
 
 bool Board::PieceStalemate() const
@@ -579,20 +748,122 @@ Piece Board::GetKing(Config::PlayerColour col) const
 
 int Board::GetMaterialBalance() const
 {
-	int balance[Config::PCOLOUR_COUNT] = {0};
+	assert(VerifyMaterialScore());
+	assert(VerifyHash());
+
+	// the mobility depends on all the pieces positions, so it is the only part that is calculated here
+	int mobility[Config::PCOLOUR_COUNT] = {0};
 	const BitBoard unoccupiedTiles = ~ (piecesBitBoards[Config::WHITE] | piecesBitBoards[Config::BLACK]);
 	BitBoard moveableTiles;
 	for(int i = 0; i < pieces[Config::WHITE].Count(); ++i)
 	{
 		moveableTiles = movePool->GetPieceFullMoves(pieces[Config::WHITE][i]) & unoccupiedTiles;
-		balance[Config::WHITE] += pieces[Config::WHITE][i].GetWorth() + pieces[Config::WHITE][i].GetPositionWorth(pieces[Config::WHITE][i].GetPositionVector()) + moveableTiles.GetBitCount();
+		mobility[Config::WHITE] += moveableTiles.GetBitCount();
 	}
 	for(int i = 0; i < pieces[Config::BLACK].Count(); ++i)
 	{
-		moveableTiles = movePool->GetPieceFullMoves(pieces[Config::WHITE][i]) & unoccupiedTiles;
-		balance[Config::BLACK] += pieces[Config::BLACK][i].GetWorth() + pieces[Config::BLACK][i].GetPositionWorth(pieces[Config::BLACK][i].GetPositionVector()) + moveableTiles.GetBitCount();
+		moveableTiles = movePool->GetPieceFullMoves(pieces[Config::BLACK][i]) & unoccupiedTiles;
+		mobility[Config::BLACK] += moveableTiles.GetBitCount();
+	}
+	return materialScore + mobility[Config::WHITE] - mobility[Config::BLACK];
+}
+
+int Board::CalculateMaterialScore() const
+{
+	int score = 0;
+	for(int i = 0; i < pieces[Config::WHITE].Count(); ++i)
+	{
+		score += GetPieceScore(pieces[Config::WHITE][i]);
+	}
+	for(int i = 0; i < pieces[Config::BLACK].Count(); ++i)
+	{
+		score += GetPieceScore(pieces[Config::BLACK][i]);
+	}
+	return score;
+}
+
+bool Board::VerifyMaterialScore() const
+{
+	return materialScore == CalculateMaterialScore();
+}
+
+unsigned long long Board::CalculateHash(bool pawnsOnly) const
+{
+	unsigned long long result = 0ULL;
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		for(int i = 0; i < pieces[colour].Count(); ++i)
+		{
+			if(!pawnsOnly || pieces[colour][i].GetType() == Config::PAWN)
+			{
+				result ^= GetPieceHash(pieces[colour][i]);
+			}
+		}
 	}
-	return balance[Config::WHITE] - balance[Config::BLACK];
+	return result;
+}
+
+bool Board::VerifyHash() const
+{
+	return hash == CalculateHash() && pawnHash == CalculateHash(true);
+}
+
+void Board::EvaluatePawnStructure(PawnStructure& result) const
+{
+	BitBoard pawns[Config::PCOLOUR_COUNT];
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		for(int i = 0; i < pieces[colour].Count(); ++i)
+		{
+			if(pieces[colour][i].GetType() == Config::PAWN)
+			{
+				pawns[colour].SetBit(true, pieces[colour][i].GetPositionCoord());
+			}
+		}
+	}
+
+	const BitBoard allPawns = pawns[Config::WHITE] | pawns[Config::BLACK];
+	int score[Config::PCOLOUR_COUNT] = {0};
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		const Config::PlayerColour pawnColour = (Config::PlayerColour) colour;
+		const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(pawnColour);
+		const ChessVector reproduction = Const::PAWN_REPRODUCE_VECTORS[colour];
+		const int direction = (pawnColour == Config::WHITE ? 1 : -1);
+
+		result.passedPawns[colour].Zero();
+		BitBoard colourPawns(pawns[colour]);
+		for(coord pos = colourPawns.PopFirstBit(); pos >= 0; pos = colourPawns.PopFirstBit())
+		{
+			const ChessVector pawnPos(pos);
+
+			if(!(movePool->GetPawnFrontSpan(pawnColour, pos) & pawns[oppositeColour]))
+			{
+				// the closer to the reproduction, the more the passed pawn is worth
+				const int distance = Utils::Abs(pawnPos.y - reproduction.y) + Utils::Abs(pawnPos.z - reproduction.z);
+				score[colour] += Const::PAWN_PASSED_WORTH + Utils::Max(0, Const::PAWN_DISTANCE_TO_REPRODUCTION - distance) * Const::PAWN_PASSED_STEP_WORTH;
+				result.passedPawns[colour].SetBit(true, pos);
+			}
+
+			if(!(movePool->GetAdjacentFiles(pos) & pawns[colour]))
+			{
+				score[colour] -= Const::PAWN_ISOLATED_PENALTY;
+			}
+
+			// the pawn is blocked if it can't move forward in any of its directions
+			const ChessVector forwardY(pawnPos.x, pawnPos.y + direction, pawnPos.z);
+			const ChessVector forwardZ(pawnPos.x, pawnPos.y, pawnPos.z + direction);
+			const bool blockedY = !ValidVector(forwardY) || allPawns.GetBit(forwardY.GetVectorCoord());
+			const bool blockedZ = !ValidVector(forwardZ) || allPawns.GetBit(forwardZ.GetVectorCoord());
+			if(blockedY && blockedZ)
+			{
+				score[colour] -= Const::PAWN_BLOCKED_PENALTY;
+			}
+		}
+	}
+
+	result.pawnHash = pawnHash;
+	result.score = score[Config::WHITE] - score[Config::BLACK];
 }
 
 int Board::GetTileWorth(ChessVector pos) const
@@ -610,10 +881,27 @@ int Board::GetTileWorth(ChessVector pos) const
 	return tileWorth;
 }
 
+bool Board::IsRepetition() const
+{
+	// the same player is on move every second ply, and the position two plies back always differs in the moved pieces
+	const int count = hashHistory.Count();
+	const int window = Utils::Min(reversiblePlies, count);
+	for(int back = 4; back <= window; back += 2)
+	{
+		if(hashHistory[count - back] == hash)
+			return true;
+	}
+	return false;
+}
+
 void Board::AddPiece(Piece piece)
 {
 	pieces[piece.GetColour()] += piece;
 	piecesBitBoards[piece.GetColour()].SetBit(true, piece.GetPositionCoord());
+	materialScore += GetPieceScore(piece);
+	TogglePieceHash(piece);
+	UpdateAccumulator(piece, true);
+	RefreshDirtyAccumulators();
 }
 
 void Board::RemovePiece(ChessVector pos)
@@ -623,13 +911,114 @@ void Board::RemovePiece(ChessVector pos)
 	if( index != -1 && colour != Config::BOTH_COLOURS)
 	{
 		piecesBitBoards[colour].SetBit(false, pieces[colour][index].GetPositionCoord());
+		materialScore -= GetPieceScore(pieces[colour][index]);
+		TogglePieceHash(pieces[colour][index]);
+		UpdateAccumulator(pieces[colour][index], false);
 		pieces[colour].RemoveItem(index);
+		RefreshDirtyAccumulators();
+	}
+}
+
+void Board::Clear()
+{
+	pieces[Config::WHITE].Clear();
+	pieces[Config::BLACK].Clear();
+	piecesBitBoards[Config::WHITE].Zero();
+	piecesBitBoards[Config::BLACK].Zero();
+	materialScore = 0;
+	hash = 0ULL;
+	pawnHash = 0ULL;
+	hashHistory.Clear();
+	reversiblePlies = 0;
+	RefreshAccumulator(Config::WHITE);
+	RefreshAccumulator(Config::BLACK);
+}
+
+void Board::SetNetwork(const NnueNetwork * net)
+{
+	network = (net && net->IsLoaded() ? net : nullptr);
+	RefreshAccumulator(Config::WHITE);
+	RefreshAccumulator(Config::BLACK);
+}
+
+void Board::UpdateNetworkFeatures(Piece piece, bool add, bool moving)
+{
+	for(int perspective = 0; perspective < Config::PCOLOUR_COUNT; ++perspective)
+	{
+		// the perspective will be calculated from scratch at the end of the board change
+		if(accumulatorDirty[perspective])
+			continue;
+
+		const int feature = NnueNetwork::GetFeatureIndex((Config::PlayerColour) perspective, accumulatorKingBuckets[perspective], piece);
+		if(feature < 0)
+		{
+			// the own king isn't a feature, the others change only with its bucket (the moving king is compared on its new tile)
+			if(add || !moving)
+			{
+				const int kingBucket = NnueNetwork::GetKingBucket((Config::PlayerColour) perspective, add ? piece.GetPositionCoord() : -1);
+				if(kingBucket != accumulatorKingBuckets[perspective])
+					accumulatorDirty[perspective] = true;
+			}
+		}
+		else if(add)
+		{
+			network->AddFeature(accumulator.values[perspective], feature);
+		}
+		else
+		{
+			network->SubtractFeature(accumulator.values[perspective], feature);
+		}
+	}
+}
+
+void Board::RefreshAccumulator(Config::PlayerColour perspective)
+{
+	accumulatorDirty[perspective] = false;
+	accumulatorKingBuckets[perspective] = 0;
+	if(!network)
+	{
+		memset(accumulator.values[perspective], 0, sizeof(accumulator.values[perspective]));
+		return;
 	}
+
+	const Piece king = GetKing(perspective);
+	const coord kingPos = (king.GetType() == Config::KING ? king.GetPositionCoord() : -1);
+	accumulatorKingBuckets[perspective] = NnueNetwork::GetKingBucket(perspective, kingPos);
+
+	short * values = accumulator.values[perspective];
+	network->ResetAccumulator(values);
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		for(int i = 0; i < pieces[colour].Count(); ++i)
+		{
+			const int feature = NnueNetwork::GetFeatureIndex(perspective, accumulatorKingBuckets[perspective], pieces[colour][i]);
+			if(feature >= 0)
+			{
+				network->AddFeature(values, feature);
+			}
+		}
+	}
+}
+
+bool Board::VerifyAccumulator() const
+{
+	if(!network)
+		return true;
+
+	Board fresh(*this);
+	fresh.SetNetwork(network);
+	return memcmp(&fresh.accumulator, &accumulator, sizeof(accumulator)) == 0;
 }
 
 void Board::SetMovePool(BitBoardMovePool * pool)
 {
 	movePool = pool;
+	// the hash keys come from the move pool
+	hash = CalculateHash();
+	pawnHash = CalculateHash(true);
+	// the previous hashes were calculated with the other keys
+	hashHistory.Clear();
+	reversiblePlies = 0;
 }
 
 BoardTileState::BoardTileState()
@@ -1,20 +1,38 @@
 #include <SDL.h>
 #include "raumschach.h"
 #include "configuration.h"
+#include "bench.h"
 
 #include <unordered_map>
 #include <iostream>
 #include "utils.h"
 #include <ctime>
+#include <cstring>
+#include <cstdlib>
 
 // Project total lines - 3733 - commit - 8b845894 - 12.01.14 - 01:12:15
 
 int main(int argc, char **argv)
 {
 
+	// "bench [depth]" runs the regression benchmark without opening the window
+	if(argc > 1 && strcmp(argv[1], "bench") == 0)
+	{
+		Bench::Run(argc > 2 ? atoi(argv[2]) : Config::BENCH_DEPTH);
+		return 0;
+	}
+
 	Raumschach rchess;
 
-	rchess.Initialize();
+	// -deterministic makes the ai games reproducible (fixed random seed and search node budget)
+	bool deterministic = false;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-deterministic") == 0)
+			deterministic = true;
+	}
+
+	rchess.Initialize(deterministic);
 	rchess.Start();
 
 	return 0;
@@ -0,0 +1,137 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+MappedFile::MappedFile()
+	:
+	data(nullptr),
+	size(0ULL),
+	fileHandle(nullptr),
+	mappingHandle(nullptr)
+{}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char * filename)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const unsigned char *) view;
+	size = (unsigned long long) fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data)
+	{
+		UnmapViewOfFile(data);
+		data = nullptr;
+	}
+	if(mappingHandle)
+	{
+		CloseHandle((HANDLE) mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if(fileHandle)
+	{
+		CloseHandle((HANDLE) fileHandle);
+		fileHandle = nullptr;
+	}
+	size = 0ULL;
+}
+
+#else
+
+bool MappedFile::Open(const char * filename)
+{
+	Close();
+
+	int file = open(filename, O_RDONLY);
+	if(file < 0)
+		return false;
+
+	struct stat fileStat;
+	if(fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void * view = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, file, 0);
+	// the mapping holds its own reference to the file, so the descriptor isn't needed anymore
+	close(file);
+	if(view == MAP_FAILED)
+		return false;
+
+	data = (const unsigned char *) view;
+	size = (unsigned long long) fileStat.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data)
+	{
+		munmap((void *) data, (size_t) size);
+		data = nullptr;
+	}
+	size = 0ULL;
+}
+
+#endif // _WIN32
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
+
+const unsigned char * MappedFile::GetData() const
+{
+	return data;
+}
+
+unsigned long long MappedFile::GetSize() const
+{
+	return size;
+}
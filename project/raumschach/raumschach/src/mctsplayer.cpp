@@ -0,0 +1,404 @@
+#include "configuration.h"
+#include "constants.h"
+#include "mctsplayer.h"
+#include "board.h"
+#include "random_generator.h"
+#include <cmath>
+#include <thread>
+#include <vector>
+
+/********* class MCTSNodePool ***********/
+
+MCTSNodePool::MCTSNodePool(int capacity)
+	:	nodes(nullptr), capacity(capacity), used(0)
+{
+	nodes = new MCTSNode[capacity];
+}
+
+MCTSNodePool::~MCTSNodePool()
+{
+	delete[] nodes;
+	nodes = nullptr;
+}
+
+int MCTSNodePool::Allocate(int count)
+{
+	int first = used.load(std::memory_order_relaxed);
+	do
+	{
+		if(first + count > capacity)
+			return -1;
+	}
+	while(!used.compare_exchange_weak(first, first + count, std::memory_order_relaxed));
+	return first;
+}
+
+void MCTSNodePool::Clear()
+{
+	used.store(0);
+}
+
+int MCTSNodePool::GetUsed() const
+{
+	return used.load();
+}
+
+/********** class MCTSPlayer ************/
+
+namespace
+{
+	inline void InitializeNode(MCTSNode& node, float prior, coord source, coord destination)
+	{
+		node.visits.store(0, std::memory_order_relaxed);
+		node.value.store(0LL, std::memory_order_relaxed);
+		node.state.store(MCTS_LEAF, std::memory_order_relaxed);
+		node.firstChild = -1;
+		node.childCount = 0;
+		node.prior = prior;
+		node.source = source;
+		node.destination = destination;
+	}
+
+	// the running playout counts as lost until it finishes, so the other threads prefer the other paths meanwhile
+	inline void AddVirtualLoss(MCTSNode& node)
+	{
+		node.visits.fetch_add(Config::MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+		node.value.fetch_sub((long long) Config::MCTS_VIRTUAL_LOSS * Config::MCTS_RESULT_SCALE, std::memory_order_relaxed);
+	}
+
+	inline void AddResult(MCTSNode& node, int result)
+	{
+		node.value.fetch_add(result + (long long) Config::MCTS_VIRTUAL_LOSS * Config::MCTS_RESULT_SCALE, std::memory_order_relaxed);
+		node.visits.fetch_add(1 - Config::MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+	}
+}
+
+MCTSPlayer::MCTSPlayer(int playouts, int threads, Config::PlayerColour colour, unsigned seed)
+	:	Player(0, 0, colour), playouts(Utils::Max(1, playouts)), threadCount(Utils::Max(1, threads)), seed(seed), pool(nullptr), stepped(nullptr), remainingPlayouts(0)
+{
+	pool = new MCTSNodePool();
+	stepped = new MCTSSteppedSearch();
+	stepped->active = false;
+}
+
+MCTSPlayer::~MCTSPlayer()
+{
+	delete stepped;
+	stepped = nullptr;
+	delete pool;
+	pool = nullptr;
+}
+
+Config::PlayerType MCTSPlayer::GetType() const
+{
+	return Config::PLAYER_MCTS;
+}
+
+bool MCTSPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) const
+{
+	return ThinkMove(piece, pos, board, 0);
+}
+
+bool MCTSPlayer::ThinkMove(Piece& piece, ChessVector& pos, const Board * board, int count) const
+{
+	if(!board)
+		return false;
+
+	// another position than the searched one (the next move, or the board was changed meanwhile) is searched anew
+	if(!stepped->active || stepped->rootHash != board->GetPositionHash(playerColour))
+	{
+		BeginSearch(*board, playerColour);
+	}
+
+	if(!StepSearch(count))
+		return false;
+
+	const Move finalMove = GetSearchResult();
+
+	printf("Best monte carlo move for %s player:\n", Const::COLOUR_NAMES[playerColour].GetPtr());
+	printf("%s to (%d, %d, %d), h = %d\n", Const::PIECE_NAMES[finalMove.piece.GetType()].GetPtr(), finalMove.destination.x, finalMove.destination.y, finalMove.destination.z, finalMove.heuristic);
+	printf("Playouts : %d, tree nodes : %d\n\n", playouts, GetTreeSize());
+
+	piece = finalMove.piece;
+	pos = finalMove.destination;
+
+	return true;
+}
+
+Move MCTSPlayer::Search(const Board& board, Config::PlayerColour colour) const
+{
+	// the blocking search is the stepped one in a single step, so both find the same moves
+	BeginSearch(board, colour);
+	StepSearch(0);
+	return GetSearchResult();
+}
+
+void MCTSPlayer::BeginSearch(const Board& board, Config::PlayerColour colour) const
+{
+	stepped->board = board;
+	stepped->colour = colour;
+	stepped->rootHash = board.GetPositionHash(colour);
+	stepped->playoutsLeft = playouts;
+	stepped->step = 0;
+	stepped->active = true;
+
+	pool->Clear();
+	InitializeNode((*pool)[pool->Allocate(1)], 1.0f, -1, -1);
+}
+
+bool MCTSPlayer::StepSearch(int count) const
+{
+	if(!stepped->active)
+		return true;
+
+	const int stepPlayouts = (count > 0 ? Utils::Min(count, stepped->playoutsLeft) : stepped->playoutsLeft);
+	stepped->playoutsLeft -= stepPlayouts;
+	remainingPlayouts.store(stepPlayouts);
+
+	// the calling thread is one of the searching threads
+	const unsigned stepSeed = seed + (unsigned) (stepped->step * threadCount);
+	std::vector<std::thread> helpers;
+	for(int t = 1; t < threadCount; ++t)
+	{
+		helpers.push_back(std::thread(&MCTSPlayer::RunPlayouts, this, std::cref(stepped->board), stepped->colour, stepSeed + (unsigned) t));
+	}
+	RunPlayouts(stepped->board, stepped->colour, stepSeed);
+	for(int t = 0; t < (int) helpers.size(); ++t)
+	{
+		helpers[t].join();
+	}
+
+	stepped->step++;
+	if(stepped->playoutsLeft > 0)
+		return false;
+
+	stepped->active = false;
+	return true;
+}
+
+Move MCTSPlayer::GetSearchResult() const
+{
+	const MCTSNode& root = (*pool)[0];
+	if(root.state.load() != MCTS_EXPANDED || root.childCount == 0)
+		return Move();
+
+	// the most visited move is the most reliable one, its average result may be lucky
+	int bestChild = root.firstChild;
+	for(int i = root.firstChild + 1; i < root.firstChild + root.childCount; ++i)
+	{
+		if((*pool)[i].visits.load() > (*pool)[bestChild].visits.load())
+			bestChild = i;
+	}
+
+	// the root moves are generated again for the move bitboard of the best one
+	Board boardCopy(stepped->board);
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	boardCopy.GetPossibleMoves(stepped->colour, moves);
+	const MCTSNode& best = (*pool)[bestChild];
+	Move bestMove;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		if(moves[i].piece.GetPositionCoord() == best.source && moves[i].destination.GetVectorCoord() == best.destination)
+			bestMove = moves[i];
+	}
+
+	// the average result is the tanh of the evaluation, so the heuristic is in the same units as the alpha-beta scores
+	const int visits = Utils::Max(1, best.visits.load());
+	const float average = Utils::Max(-0.999f, Utils::Min(0.999f, (float) best.value.load() / ((float) visits * Config::MCTS_RESULT_SCALE)));
+	bestMove.heuristic = (int) (atanhf(average) * Config::MCTS_EVAL_SCALE);
+	return bestMove;
+}
+
+int MCTSPlayer::GetTreeSize() const
+{
+	return pool->GetUsed();
+}
+
+void MCTSPlayer::RunPlayouts(const Board& root, Config::PlayerColour colour, unsigned threadSeed) const
+{
+	Board board(root);
+	// the playouts are evaluated by the material balance, the network doesn't have to be updated
+	board.SetNetwork(nullptr);
+	RandomGenerator rgen(threadSeed);
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	int path[Config::MAX_SEARCH_PLY];
+	MadeMove madeMoves[Config::MAX_SEARCH_PLY];
+
+	while(remainingPlayouts.fetch_sub(1) > 0)
+	{
+		int length = 1;
+		path[0] = 0;
+		AddVirtualLoss((*pool)[0]);
+		Config::PlayerColour onMove = colour;
+		bool resolved = false;
+		int result = 0;
+
+		for(;;)
+		{
+			MCTSNode& node = (*pool)[path[length - 1]];
+			const int state = node.state.load(std::memory_order_acquire);
+			if(state == MCTS_LEAF)
+			{
+				int expected = MCTS_LEAF;
+				if(node.state.compare_exchange_strong(expected, MCTS_EXPANDING, std::memory_order_acquire))
+				{
+					Expand(node, board, onMove, moves);
+				}
+				break;
+			}
+			// the node being expanded by another thread is played out like a leaf
+			if(state == MCTS_EXPANDING)
+				break;
+
+			// without moves the player is either mated or it is a stalemate
+			if(node.childCount == 0)
+			{
+				result = (board.KingInCheck(onMove) ? - Config::MCTS_RESULT_SCALE : 0);
+				resolved = true;
+				break;
+			}
+			if(length >= Config::MAX_SEARCH_PLY)
+				break;
+
+			const int childIndex = SelectChild(node);
+			MCTSNode& child = (*pool)[childIndex];
+			// the moves of the tree are legal, so the move bitboard is not needed
+			madeMoves[length - 1] = board.MovePiece(board.GetPiece(ChessVector(child.source)), ChessVector(child.destination), BitBoard(), true);
+			onMove = Config::GetOppositePlayer(onMove);
+			path[length++] = childIndex;
+			AddVirtualLoss(child);
+
+			// the players can repeat the cycle forever, so a repeated position is a draw for both of them
+			if(board.IsRepetition())
+			{
+				resolved = true;
+				break;
+			}
+		}
+
+		if(!resolved)
+		{
+			result = Playout(board, onMove, moves, rgen);
+		}
+
+		for(int i = length - 2; i >= 0; --i)
+		{
+			board.UndoMove(madeMoves[i]);
+		}
+
+		// the node value is for the player who moved to it, the opponent of the one on move in it
+		for(int i = length - 1; i >= 0; --i)
+		{
+			result = - result;
+			AddResult((*pool)[path[i]], result);
+		}
+	}
+}
+
+bool MCTSPlayer::Expand(MCTSNode& node, Board& board, Config::PlayerColour colour, DynamicArray<Move>& moves) const
+{
+	moves.Clear();
+	board.GetPossibleMoves(colour, moves);
+
+	int first = -1;
+	if(moves.Count() > 0)
+	{
+		first = pool->Allocate(moves.Count());
+		if(first < 0)
+		{
+			node.state.store(MCTS_LEAF, std::memory_order_release);
+			return false;
+		}
+	}
+
+	// the priors are the softmax of the move heuristics
+	int bestHeuristic = Config::INT_NEGATIVE_INFINITY;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		moves[i].heuristic = MoveHeuristic(moves[i], board);
+		bestHeuristic = Utils::Max(bestHeuristic, moves[i].heuristic);
+	}
+	float sum = 0.0f;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		sum += expf((float) (moves[i].heuristic - bestHeuristic) / Config::MCTS_PRIOR_TEMPERATURE);
+	}
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		const float prior = expf((float) (moves[i].heuristic - bestHeuristic) / Config::MCTS_PRIOR_TEMPERATURE) / sum;
+		InitializeNode((*pool)[first + i], prior, moves[i].piece.GetPositionCoord(), moves[i].destination.GetVectorCoord());
+	}
+
+	node.firstChild = first;
+	node.childCount = moves.Count();
+	// the children must be ready before the other threads see the node expanded
+	node.state.store(MCTS_EXPANDED, std::memory_order_release);
+	return true;
+}
+
+int MCTSPlayer::SelectChild(const MCTSNode& node) const
+{
+	const float exploration = Config::MCTS_EXPLORATION * sqrtf((float) Utils::Max(1, node.visits.load(std::memory_order_relaxed)));
+
+	int bestChild = node.firstChild;
+	float bestScore = - HUGE_VALF;
+	for(int i = node.firstChild; i < node.firstChild + node.childCount; ++i)
+	{
+		const MCTSNode& child = (*pool)[i];
+		const int visits = child.visits.load(std::memory_order_relaxed);
+		const float average = (visits > 0 ? (float) child.value.load(std::memory_order_relaxed) / ((float) visits * Config::MCTS_RESULT_SCALE) : 0.0f);
+		const float score = average + exploration * child.prior / (float) (1 + visits);
+		if(score > bestScore)
+		{
+			bestScore = score;
+			bestChild = i;
+		}
+	}
+	return bestChild;
+}
+
+int MCTSPlayer::Playout(Board& board, Config::PlayerColour colour, DynamicArray<Move>& moves, RandomGenerator& rgen) const
+{
+	MadeMove madeMoves[Config::MCTS_PLAYOUT_PLIES];
+	Config::PlayerColour onMove = colour;
+	bool ended = false;
+	int result = 0;
+	int plies = 0;
+	for(; plies < Config::MCTS_PLAYOUT_PLIES; ++plies)
+	{
+		moves.Clear();
+		board.GetPossibleMoves(onMove, moves);
+		if(moves.Count() == 0)
+		{
+			result = (board.KingInCheck(onMove) ? - Config::MCTS_RESULT_SCALE : 0);
+			ended = true;
+			break;
+		}
+
+		// the better of two random moves, so the captures are played more often than the quiet moves
+		const Move& first = moves[rgen.GetRand(moves.Count())];
+		const Move& second = moves[rgen.GetRand(moves.Count())];
+		const Move& move = (MoveHeuristic(first, board) >= MoveHeuristic(second, board) ? first : second);
+		madeMoves[plies] = board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+		onMove = Config::GetOppositePlayer(onMove);
+	}
+
+	if(!ended)
+	{
+		const int score = board.GetMaterialBalance() * (onMove == Config::WHITE ? 1 : -1);
+		result = (int) (tanhf((float) score / Config::MCTS_EVAL_SCALE) * Config::MCTS_RESULT_SCALE);
+	}
+
+	for(int i = plies - 1; i >= 0; --i)
+	{
+		board.UndoMove(madeMoves[i]);
+	}
+
+	// the result is for the player on move at the end of the playout
+	return (onMove == colour ? result : - result);
+}
+
+int MCTSPlayer::MoveHeuristic(const Move& move, const Board& board)
+{
+	return move.piece.GetPositionWorth(move.destination) + board.GetPiece(move.destination).GetWorth();
+}
@@ -0,0 +1,270 @@
+#include "nnue.h"
+#include <stdio.h>
+#include <string.h>
+
+// the kernels use the widest available instruction set, the scalar version is for the other platforms
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NNUE_USE_SSE2
+#endif
+
+namespace
+{
+	// the clipped relu of both perspectives, the input of the dense layer
+	void ActivateAccumulator(const NnueAccumulator& accumulator, short * output)
+	{
+		const int size = Config::NNUE_HIDDEN_SIZE;
+#if defined(NNUE_USE_AVX2)
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i maximum = _mm256_set1_epi16(Config::NNUE_ACTIVATION_MAX);
+		for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+		{
+			for(int i = 0; i < size; i += 16)
+			{
+				__m256i value = _mm256_loadu_si256((const __m256i *) &accumulator.values[colour][i]);
+				value = _mm256_min_epi16(_mm256_max_epi16(value, zero), maximum);
+				_mm256_storeu_si256((__m256i *) &output[colour * size + i], value);
+			}
+		}
+#elif defined(NNUE_USE_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i maximum = _mm_set1_epi16(Config::NNUE_ACTIVATION_MAX);
+		for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+		{
+			for(int i = 0; i < size; i += 8)
+			{
+				__m128i value = _mm_loadu_si128((const __m128i *) &accumulator.values[colour][i]);
+				value = _mm_min_epi16(_mm_max_epi16(value, zero), maximum);
+				_mm_storeu_si128((__m128i *) &output[colour * size + i], value);
+			}
+		}
+#else
+		for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+		{
+			for(int i = 0; i < size; ++i)
+			{
+				const short value = accumulator.values[colour][i];
+				output[colour * size + i] = Utils::Min<short>(Utils::Max<short>(value, 0), Config::NNUE_ACTIVATION_MAX);
+			}
+		}
+#endif
+	}
+
+	// the dot product of two int16 vectors with the specified size (multiple of 16)
+	int DotProduct(const short * lhs, const short * rhs, int size)
+	{
+#if defined(NNUE_USE_AVX2)
+		__m256i sum = _mm256_setzero_si256();
+		for(int i = 0; i < size; i += 16)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i *) &lhs[i]);
+			const __m256i b = _mm256_loadu_si256((const __m256i *) &rhs[i]);
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, b));
+		}
+		__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(half);
+#elif defined(NNUE_USE_SSE2)
+		__m128i sum = _mm_setzero_si128();
+		for(int i = 0; i < size; i += 8)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *) &lhs[i]);
+			const __m128i b = _mm_loadu_si128((const __m128i *) &rhs[i]);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(a, b));
+		}
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(sum);
+#else
+		int sum = 0;
+		for(int i = 0; i < size; ++i)
+		{
+			sum += (int) lhs[i] * (int) rhs[i];
+		}
+		return sum;
+#endif
+	}
+}
+
+NnueNetwork::NnueNetwork()
+	:
+	featureWeights(nullptr),
+	featureBiases(nullptr),
+	hiddenWeights(nullptr),
+	hiddenBiases(nullptr),
+	outputWeights(nullptr),
+	outputBias(0)
+{}
+
+NnueNetwork::~NnueNetwork()
+{
+	Free();
+}
+
+void NnueNetwork::Free()
+{
+	delete[] featureWeights;
+	featureWeights = nullptr;
+	delete[] featureBiases;
+	featureBiases = nullptr;
+	delete[] hiddenWeights;
+	hiddenWeights = nullptr;
+	delete[] hiddenBiases;
+	hiddenBiases = nullptr;
+	delete[] outputWeights;
+	outputWeights = nullptr;
+	outputBias = 0;
+}
+
+bool NnueNetwork::Load(const char * filename)
+{
+	Free();
+
+	FILE * input = fopen(filename, "rb");
+	if(!input)
+		return false;
+
+	NnueHeader header;
+	bool valid = fread(&header, sizeof(header), 1, input) == 1
+		&& memcmp(header.magic, Config::NNUE_MAGIC, sizeof(header.magic)) == 0
+		&& header.featureCount == (unsigned) Config::NNUE_FEATURE_COUNT
+		&& header.hiddenSize == (unsigned) Config::NNUE_HIDDEN_SIZE
+		&& header.hidden2Size == (unsigned) Config::NNUE_HIDDEN2_SIZE;
+
+	if(valid)
+	{
+		const int featureWeightCount = Config::NNUE_FEATURE_COUNT * Config::NNUE_HIDDEN_SIZE;
+		const int hiddenWeightCount = Config::NNUE_HIDDEN2_SIZE * Config::NNUE_HIDDEN_SIZE * 2;
+
+		featureWeights = new short[featureWeightCount];
+		featureBiases = new short[Config::NNUE_HIDDEN_SIZE];
+		hiddenWeights = new short[hiddenWeightCount];
+		hiddenBiases = new int[Config::NNUE_HIDDEN2_SIZE];
+		outputWeights = new short[Config::NNUE_HIDDEN2_SIZE];
+
+		valid = fread(featureWeights, sizeof(short), featureWeightCount, input) == (size_t) featureWeightCount
+			&& fread(featureBiases, sizeof(short), Config::NNUE_HIDDEN_SIZE, input) == (size_t) Config::NNUE_HIDDEN_SIZE
+			&& fread(hiddenWeights, sizeof(short), hiddenWeightCount, input) == (size_t) hiddenWeightCount
+			&& fread(hiddenBiases, sizeof(int), Config::NNUE_HIDDEN2_SIZE, input) == (size_t) Config::NNUE_HIDDEN2_SIZE
+			&& fread(outputWeights, sizeof(short), Config::NNUE_HIDDEN2_SIZE, input) == (size_t) Config::NNUE_HIDDEN2_SIZE
+			&& fread(&outputBias, sizeof(int), 1, input) == 1;
+	}
+	fclose(input);
+
+	if(!valid)
+	{
+		Free();
+	}
+	return valid;
+}
+
+bool NnueNetwork::IsLoaded() const
+{
+	return featureWeights != nullptr;
+}
+
+int NnueNetwork::GetKingBucket(Config::PlayerColour perspective, coord kingPos)
+{
+	if(kingPos < 0)
+		return 0;
+
+	const coord level = ChessVector(kingPos).z;
+	return (perspective == Config::WHITE ? level : Config::BOARD_SIDE - 1 - level);
+}
+
+int NnueNetwork::GetFeatureIndex(Config::PlayerColour perspective, int kingBucket, Piece piece)
+{
+	const Config::PieceType type = piece.GetType();
+	int kind = 0;
+	if(piece.GetColour() == perspective)
+	{
+		if(type == Config::KING)
+			return -1;
+		kind = type - Config::QUEEN;
+	}
+	else
+	{
+		kind = (Config::PIECE_TYPE_COUNT - Config::QUEEN) + type - Config::KING;
+	}
+
+	ChessVector pos = piece.GetPositionVector();
+	if(perspective == Config::BLACK)
+	{
+		pos.y = Config::BOARD_SIDE - 1 - pos.y;
+		pos.z = Config::BOARD_SIDE - 1 - pos.z;
+	}
+
+	return (kingBucket * Config::NNUE_PIECE_KINDS + kind) * Config::BOARD_SIZE + pos.GetVectorCoord();
+}
+
+void NnueNetwork::ResetAccumulator(short * accumulator) const
+{
+	memcpy(accumulator, featureBiases, sizeof(short) * Config::NNUE_HIDDEN_SIZE);
+}
+
+void NnueNetwork::AddFeature(short * accumulator, int feature) const
+{
+	const short * weights = featureWeights + feature * Config::NNUE_HIDDEN_SIZE;
+#if defined(NNUE_USE_AVX2)
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; i += 16)
+	{
+		const __m256i value = _mm256_add_epi16(_mm256_loadu_si256((const __m256i *) &accumulator[i]), _mm256_loadu_si256((const __m256i *) &weights[i]));
+		_mm256_storeu_si256((__m256i *) &accumulator[i], value);
+	}
+#elif defined(NNUE_USE_SSE2)
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; i += 8)
+	{
+		const __m128i value = _mm_add_epi16(_mm_loadu_si128((const __m128i *) &accumulator[i]), _mm_loadu_si128((const __m128i *) &weights[i]));
+		_mm_storeu_si128((__m128i *) &accumulator[i], value);
+	}
+#else
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; ++i)
+	{
+		accumulator[i] += weights[i];
+	}
+#endif
+}
+
+void NnueNetwork::SubtractFeature(short * accumulator, int feature) const
+{
+	const short * weights = featureWeights + feature * Config::NNUE_HIDDEN_SIZE;
+#if defined(NNUE_USE_AVX2)
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; i += 16)
+	{
+		const __m256i value = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i *) &accumulator[i]), _mm256_loadu_si256((const __m256i *) &weights[i]));
+		_mm256_storeu_si256((__m256i *) &accumulator[i], value);
+	}
+#elif defined(NNUE_USE_SSE2)
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; i += 8)
+	{
+		const __m128i value = _mm_sub_epi16(_mm_loadu_si128((const __m128i *) &accumulator[i]), _mm_loadu_si128((const __m128i *) &weights[i]));
+		_mm_storeu_si128((__m128i *) &accumulator[i], value);
+	}
+#else
+	for(int i = 0; i < Config::NNUE_HIDDEN_SIZE; ++i)
+	{
+		accumulator[i] -= weights[i];
+	}
+#endif
+}
+
+int NnueNetwork::Evaluate(const NnueAccumulator& accumulator) const
+{
+	const int inputSize = Config::NNUE_HIDDEN_SIZE * 2;
+	short input[inputSize];
+	short hidden[Config::NNUE_HIDDEN2_SIZE];
+
+	ActivateAccumulator(accumulator, input);
+
+	for(int i = 0; i < Config::NNUE_HIDDEN2_SIZE; ++i)
+	{
+		const int value = (DotProduct(input, hiddenWeights + i * inputSize, inputSize) + hiddenBiases[i]) >> Config::NNUE_HIDDEN_SHIFT;
+		hidden[i] = (short) Utils::Min(Utils::Max(value, 0), Config::NNUE_ACTIVATION_MAX);
+	}
+
+	return (DotProduct(hidden, outputWeights, Config::NNUE_HIDDEN2_SIZE) + outputBias) / Config::NNUE_OUTPUT_SCALE;
+}
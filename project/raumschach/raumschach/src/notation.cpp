@@ -0,0 +1,253 @@
+#include "notation.h"
+#include "constants.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+namespace
+{
+	// the piece letters indexed by the piece type
+	const char PIECE_LETTERS[Config::PIECE_TYPE_COUNT] = { '?', 'K', 'Q', 'R', 'B', 'N', 'U', 'P' };
+
+	Config::PieceType GetLetterType(char letter)
+	{
+		const char upper = (char) toupper((unsigned char) letter);
+		for(int type = Config::KING; type < Config::PIECE_TYPE_COUNT; ++type)
+		{
+			if(PIECE_LETTERS[type] == upper)
+				return (Config::PieceType) type;
+		}
+		return Config::NO_TYPE;
+	}
+}
+
+void Notation::FormatTile(ChessVector pos, char * output)
+{
+	output[0] = (char) ('A' + pos.z);
+	output[1] = (char) ('a' + pos.x);
+	output[2] = (char) ('1' + pos.y);
+	output[3] = '\0';
+}
+
+bool Notation::ParseTile(const char * input, ChessVector& pos)
+{
+	if(!input || input[0] < 'A' || input[0] >= 'A' + Config::BOARD_SIDE
+		|| input[1] < 'a' || input[1] >= 'a' + Config::BOARD_SIDE
+		|| input[2] < '1' || input[2] >= '1' + Config::BOARD_SIDE)
+	{
+		return false;
+	}
+
+	pos = ChessVector(input[1] - 'a', input[2] - '1', input[0] - 'A');
+	return true;
+}
+
+char Notation::GetPieceLetter(Piece piece)
+{
+	const char letter = PIECE_LETTERS[piece.GetType()];
+	return piece.GetColour() == Config::WHITE ? letter : (char) tolower((unsigned char) letter);
+}
+
+void Notation::FormatMove(const Move& move, char * output)
+{
+	FormatTile(move.piece.GetPositionVector(), output);
+	FormatTile(move.destination, output + TILE_LENGTH);
+}
+
+bool Notation::ParseMove(const char * input, Board& board, Config::PlayerColour colour, Move& move)
+{
+	ChessVector source;
+	ChessVector destination;
+	if(!input || strlen(input) < MOVE_LENGTH || !ParseTile(input, source) || !ParseTile(input + TILE_LENGTH, destination))
+		return false;
+
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	board.GetPossibleMoves(colour, moves);
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		if(moves[i].piece.GetPositionCoord() == source.GetVectorCoord() && moves[i].destination.GetVectorCoord() == destination.GetVectorCoord())
+		{
+			move = moves[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Notation::ParsePosition(const char * input, DynamicArray<Piece>& pieces, Config::PlayerColour& colourToMove)
+{
+	pieces.Clear();
+	if(!input)
+		return false;
+
+	while(isspace((unsigned char) *input))
+		++input;
+
+	if(*input == 'w')
+		colourToMove = Config::WHITE;
+	else if(*input == 'b')
+		colourToMove = Config::BLACK;
+	else
+		return false;
+	++input;
+
+	bool occupied[Config::BOARD_SIZE] = { false };
+	int kings[Config::PCOLOUR_COUNT] = { 0, 0 };
+	while(*input)
+	{
+		if(isspace((unsigned char) *input))
+		{
+			++input;
+			continue;
+		}
+
+		const Config::PieceType type = GetLetterType(*input);
+		ChessVector pos;
+		if(type == Config::NO_TYPE || !ParseTile(input + 1, pos))
+			return false;
+
+		const coord tile = pos.GetVectorCoord();
+		if(occupied[tile])
+			return false;
+		occupied[tile] = true;
+
+		const Config::PlayerColour colour = (isupper((unsigned char) *input) ? Config::WHITE : Config::BLACK);
+		if(type == Config::KING)
+			kings[colour]++;
+
+		pieces += Piece(type, colour, pos);
+		input += 1 + TILE_LENGTH;
+	}
+
+	return kings[Config::WHITE] == 1 && kings[Config::BLACK] == 1;
+}
+
+CharString Notation::FormatPosition(const Board& board, Config::PlayerColour colourToMove)
+{
+	DynamicArray<Piece> pieces(Config::PLAYER_PIECES_COUNT * 2);
+	board.GetPiecesArray(Config::BOTH_COLOURS, pieces);
+
+	// the pieces are written by their tiles, so the same position has always the same text
+	char * text = new char[2 + pieces.Count() * (TILE_LENGTH + 2)];
+	int length = 0;
+	text[length++] = (colourToMove == Config::WHITE ? 'w' : 'b');
+	for(int tile = 0; tile < Config::BOARD_SIZE; ++tile)
+	{
+		for(int i = 0; i < pieces.Count(); ++i)
+		{
+			if(pieces[i].GetPositionCoord() == tile)
+			{
+				text[length++] = ' ';
+				text[length++] = GetPieceLetter(pieces[i]);
+				FormatTile(pieces[i].GetPositionVector(), text + length);
+				length += TILE_LENGTH;
+			}
+		}
+	}
+	text[length] = '\0';
+
+	CharString result(text);
+	delete[] text;
+	return result;
+}
+
+Notation::SearchLimits::SearchLimits()
+	:	depth(Config::AI_PLAYER_SEARCH_DEPTH), nodes(0ULL), moveTime(0), infinite(false)
+{}
+
+void Notation::SplitCommand(const char * line, std::vector<char>& buffer, std::vector<const char *>& tokens)
+{
+	buffer.assign(line, line + strlen(line) + 1);
+	tokens.clear();
+	bool inToken = false;
+	for(size_t i = 0; buffer[i]; ++i)
+	{
+		if(isspace((unsigned char) buffer[i]))
+		{
+			buffer[i] = '\0';
+			inToken = false;
+		}
+		else if(!inToken)
+		{
+			tokens.push_back(&buffer[i]);
+			inToken = true;
+		}
+	}
+}
+
+bool Notation::ParsePositionCommand(const std::vector<const char *>& tokens, BitBoardMovePool * movePool, Board& board,
+	Config::PlayerColour& colourToMove, CharString& error)
+{
+	size_t movesToken = 1;
+	while(movesToken < tokens.size() && strcmp(tokens[movesToken], "moves") != 0)
+	{
+		++movesToken;
+	}
+
+	DynamicArray<Piece> pieces;
+	Config::PlayerColour colour = Config::WHITE;
+	if(movesToken > 1 && strcmp(tokens[1], "startpos") == 0)
+	{
+		pieces = DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES));
+	}
+	else
+	{
+		// the position text is the tokens before the moves joined back together
+		std::string text;
+		for(size_t i = 1; i < movesToken; ++i)
+		{
+			text += tokens[i];
+			text += ' ';
+		}
+		if(!ParsePosition(text.c_str(), pieces, colour))
+		{
+			error = "invalid position";
+			return false;
+		}
+	}
+
+	Board result(pieces, movePool);
+	for(size_t i = movesToken + 1; i < tokens.size(); ++i)
+	{
+		Move move;
+		if(!ParseMove(tokens[i], result, colour, move))
+		{
+			error = CharString("illegal move ") + tokens[i];
+			return false;
+		}
+		result.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+		colour = Config::GetOppositePlayer(colour);
+	}
+
+	board = result;
+	colourToMove = colour;
+	return true;
+}
+
+Notation::SearchLimits Notation::ParseSearchCommand(const std::vector<const char *>& tokens)
+{
+	SearchLimits limits;
+	bool depthSet = false;
+	for(size_t i = 1; i < tokens.size(); ++i)
+	{
+		const bool hasValue = i + 1 < tokens.size();
+		if(strcmp(tokens[i], "depth") == 0 && hasValue)
+		{
+			limits.depth = atoi(tokens[++i]);
+			depthSet = true;
+		}
+		else if(strcmp(tokens[i], "nodes") == 0 && hasValue)
+			limits.nodes = strtoull(tokens[++i], nullptr, 10);
+		else if(strcmp(tokens[i], "movetime") == 0 && hasValue)
+			limits.moveTime = atoll(tokens[++i]);
+		else if(strcmp(tokens[i], "infinite") == 0)
+			limits.infinite = true;
+	}
+	// the limited searches are deepened as far as they get
+	if(!depthSet && (limits.nodes || limits.moveTime || limits.infinite))
+	{
+		limits.depth = Config::MAX_SEARCH_PLY;
+	}
+	return limits;
+}
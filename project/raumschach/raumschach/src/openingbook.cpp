@@ -0,0 +1,128 @@
+#include "openingbook.h"
+#include "board.h"
+#include "random_generator.h"
+#include <string.h>
+
+OpeningBook::OpeningBook()
+	:
+	entries(nullptr),
+	entryCount(0)
+{}
+
+OpeningBook::~OpeningBook()
+{
+	Close();
+}
+
+bool OpeningBook::Open(const char * filename)
+{
+	Close();
+	if(!file.Open(filename))
+		return false;
+
+	const BookHeader * header = (const BookHeader *) file.GetData();
+	bool valid = file.GetSize() >= sizeof(BookHeader)
+		&& memcmp(header->magic, Config::OPENING_BOOK_MAGIC, sizeof(header->magic)) == 0
+		&& file.GetSize() >= sizeof(BookHeader) + (unsigned long long) header->entryCount * sizeof(BookEntry);
+
+	if(!valid)
+	{
+		file.Close();
+		return false;
+	}
+
+	entries = (const BookEntry *) (file.GetData() + sizeof(BookHeader));
+	entryCount = (int) header->entryCount;
+	return true;
+}
+
+void OpeningBook::Close()
+{
+	file.Close();
+	entries = nullptr;
+	entryCount = 0;
+}
+
+bool OpeningBook::IsOpen() const
+{
+	return entries != nullptr;
+}
+
+int OpeningBook::GetEntryCount() const
+{
+	return entryCount;
+}
+
+int OpeningBook::FindEntries(unsigned long long hash, const BookEntry *& first) const
+{
+	first = nullptr;
+	if(!entries)
+		return 0;
+
+	// binary search for the first entry with the hash
+	int left = 0;
+	int right = entryCount;
+	while(left < right)
+	{
+		int middle = left + ((right - left) >> 1);
+		if(entries[middle].hash < hash)
+		{
+			left = middle + 1;
+		}
+		else
+		{
+			right = middle;
+		}
+	}
+
+	int count = 0;
+	while(left + count < entryCount && entries[left + count].hash == hash)
+	{
+		++count;
+	}
+
+	if(count)
+	{
+		first = entries + left;
+	}
+	return count;
+}
+
+bool OpeningBook::GetMove(const Board& board, Config::PlayerColour colour, RandomGenerator * rgen, Piece& piece, ChessVector& pos) const
+{
+	const BookEntry * found = nullptr;
+	const int count = FindEntries(board.GetPositionHash(colour), found);
+	if(!count)
+		return false;
+
+	unsigned totalWeight = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		totalWeight += found[i].weight;
+	}
+
+	// pick a move proportionally to the weights
+	unsigned choice = (rgen && totalWeight ? rgen->GetRand(totalWeight) : 0);
+	int index = 0;
+	while(index < count - 1 && choice >= found[index].weight)
+	{
+		choice -= found[index].weight;
+		++index;
+	}
+
+	// the board copy is needed for the validation, it is also a guard against hash collisions
+	Board boardCopy(board);
+	for(int i = 0; i < count; ++i)
+	{
+		const BookEntry& entry = found[(index + i) % count];
+		Piece bookPiece = boardCopy.GetPiece(ChessVector((coord) entry.source));
+		if(bookPiece.GetType() != Config::NO_TYPE && bookPiece.GetColour() == colour
+			&& boardCopy.ValidMove(bookPiece, ChessVector((coord) entry.destination)))
+		{
+			piece = bookPiece;
+			pos = ChessVector((coord) entry.destination);
+			return true;
+		}
+	}
+	return false;
+}
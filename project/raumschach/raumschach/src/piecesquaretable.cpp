@@ -0,0 +1,138 @@
+#include "piecesquaretable.h"
+#include "constants.h"
+#include <stdio.h>
+#include <string.h>
+
+int PieceSquareTable::tables[Config::PCOLOUR_COUNT][Config::PIECE_TYPE_COUNT][Config::BOARD_SIZE];
+int PieceSquareTable::pieceWorth[Config::PIECE_TYPE_COUNT];
+
+// the tables are ready before main(), so the tools that don't load a weights file get the defaults as well
+static const bool tablesInitialized = (PieceSquareTable::Reset(), true);
+
+void PieceSquareTable::Reset()
+{
+	for(int type = 0; type < Config::PIECE_TYPE_COUNT; ++type)
+	{
+		pieceWorth[type] = Const::PIECE_WORTH[type];
+	}
+	Generate(Const::PIECE_POSITION_WORTH_FACTOR, Const::PAWN_ADVANCEMENT_WORTH);
+}
+
+void PieceSquareTable::Generate(const int positionFactors[Config::PIECE_TYPE_COUNT], int pawnAdvancement)
+{
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		const ChessVector reproduction = Const::PAWN_REPRODUCE_VECTORS[colour];
+		for(int type = 0; type < Config::PIECE_TYPE_COUNT; ++type)
+		{
+			for(coord pos = 0; pos < Config::BOARD_SIZE; ++pos)
+			{
+				const ChessVector tile(pos);
+				int worth = tile.GetManhattanDistance(Const::BOARD_CENTER) * positionFactors[type];
+				if(type == Config::PAWN)
+				{
+					worth += (Const::PAWN_DISTANCE_TO_REPRODUCTION - Utils::Abs(tile.y - reproduction.y) - Utils::Abs(tile.z - reproduction.z)) * pawnAdvancement;
+				}
+				tables[colour][type][pos] = worth;
+			}
+		}
+	}
+}
+
+bool PieceSquareTable::Load(const char * filename)
+{
+	FILE * input = fopen(filename, "r");
+	if(!input)
+		return false;
+
+	// the values are read in a copy, so a malformed file doesn't leave the tables half loaded
+	static int loaded[Config::PCOLOUR_COUNT][Config::PIECE_TYPE_COUNT][Config::BOARD_SIZE];
+	int loadedWorth[Config::PIECE_TYPE_COUNT];
+	memcpy(loaded, tables, sizeof(tables));
+	memcpy(loadedWorth, pieceWorth, sizeof(pieceWorth));
+
+	bool valid = true;
+	char colourName[32] = "";
+	char typeName[32] = "";
+	while(valid && fscanf(input, "%31s", colourName) == 1)
+	{
+		if(colourName[0] == '#')
+		{
+			// skip the rest of the comment line
+			int ch = 0;
+			while((ch = fgetc(input)) != EOF && ch != '\n') {}
+			continue;
+		}
+
+		int colour = -1;
+		int type = -1;
+		const bool worthLine = strcmp(colourName, "Worth") == 0;
+		for(int i = 0; i < Config::PCOLOUR_COUNT; ++i)
+		{
+			if(strcmp(colourName, Const::COLOUR_NAMES[i].GetPtr()) == 0)
+				colour = i;
+		}
+		// the "No Type" table is never used, so only the real pieces are in the file
+		if(fscanf(input, "%31s", typeName) == 1)
+		{
+			for(int i = Config::KING; i < Config::PIECE_TYPE_COUNT; ++i)
+			{
+				if(strcmp(typeName, Const::PIECE_NAMES[i].GetPtr()) == 0)
+					type = i;
+			}
+		}
+
+		if(worthLine)
+		{
+			valid = type >= 0 && fscanf(input, "%d", &loadedWorth[type]) == 1;
+			continue;
+		}
+
+		valid = colour >= 0 && type >= 0;
+		for(coord pos = 0; pos < Config::BOARD_SIZE && valid; ++pos)
+		{
+			valid = fscanf(input, "%d", &loaded[colour][type][pos]) == 1;
+		}
+	}
+	fclose(input);
+
+	if(valid)
+	{
+		memcpy(tables, loaded, sizeof(tables));
+		memcpy(pieceWorth, loadedWorth, sizeof(pieceWorth));
+	}
+	return valid;
+}
+
+bool PieceSquareTable::Save(const char * filename)
+{
+	FILE * output = fopen(filename, "w");
+	if(!output)
+		return false;
+
+	fprintf(output, "# Raumschach piece square tables\n");
+	fprintf(output, "# every table has one row of tiles per line, the levels are separated by an empty line\n\n");
+	for(int type = Config::KING; type < Config::PIECE_TYPE_COUNT; ++type)
+	{
+		fprintf(output, "Worth %s %d\n", Const::PIECE_NAMES[type].GetPtr(), pieceWorth[type]);
+	}
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		for(int type = Config::KING; type < Config::PIECE_TYPE_COUNT; ++type)
+		{
+			fprintf(output, "\n%s %s\n", Const::COLOUR_NAMES[colour].GetPtr(), Const::PIECE_NAMES[type].GetPtr());
+			for(coord pos = 0; pos < Config::BOARD_SIZE; ++pos)
+			{
+				fprintf(output, "%4d", tables[colour][type][pos]);
+				if((pos + 1) % Config::BOARD_SIDE == 0)
+					fprintf(output, "\n");
+				if((pos + 1) % (Config::BOARD_SIDE * Config::BOARD_SIDE) == 0 && pos + 1 < Config::BOARD_SIZE)
+					fprintf(output, "\n");
+			}
+		}
+	}
+
+	const bool written = ferror(output) == 0;
+	fclose(output);
+	return written;
+}
@@ -2,9 +2,35 @@
 #include "constants.h"
 #include "player.h"
 #include "board.h"
+#include "openingbook.h"
+#include "tablebase.h"
+#include "nnue.h"
+#include <assert.h>
 #include <cmath>
 #include <ctime>
 
+namespace
+{
+	// the mate scores are stored relative to the position, so they are right in the other paths to it
+	inline int ScoreToTable(int score, int ply)
+	{
+		if(score > Config::MATE_THRESHOLD)
+			return score + ply;
+		if(score < - Config::MATE_THRESHOLD)
+			return score - ply;
+		return score;
+	}
+
+	inline int ScoreFromTable(int score, int ply)
+	{
+		if(score > Config::MATE_THRESHOLD)
+			return score - ply;
+		if(score < - Config::MATE_THRESHOLD)
+			return score + ply;
+		return score;
+	}
+}
+
 Player::Player(int depth, int iterations, Config::PlayerColour colour)
 	:	searchDepth(depth), playerColour(colour), iterations(iterations)
 {}
@@ -38,17 +64,174 @@ bool HumanPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) c
 	return false;
 }
 
+/*********** class MoveArena ************/
+
+MoveArena::MoveArena(int plies, int movesPerPly)
+	:	plyCount(plies), plyMoves(nullptr)
+{
+	plyMoves = new DynamicArray<Move>[plyCount];
+	for(int i = 0; i < plyCount; ++i)
+	{
+		plyMoves[i].Alloc(movesPerPly);
+	}
+}
+
+MoveArena::~MoveArena()
+{
+	delete[] plyMoves;
+	plyMoves = nullptr;
+}
+
+/******** class TransitionTable *********/
+
+TransitionTable::TransitionTable(int size)
+	:	entries(nullptr), mask(0ULL)
+{
+	int entryCount = 1;
+	while(entryCount * 2 <= size)
+	{
+		entryCount *= 2;
+	}
+
+	entries = new TransitionSlot[entryCount];
+	mask = (unsigned long long) (entryCount - 1);
+	Clear();
+}
+
+TransitionTable::~TransitionTable()
+{
+	delete[] entries;
+	entries = nullptr;
+}
+
+int TransitionTable::GetSizeForMegabytes(int megabytes)
+{
+	const long long size = (long long) megabytes * (1LL << 20) / (long long) sizeof(TransitionSlot);
+	return (int) Utils::Max(1LL, Utils::Min(size, 1LL << 30));
+}
+
+void TransitionTable::Clear()
+{
+	for(int i = 0; i < GetSize(); ++i)
+	{
+		entries[i].key.store(0ULL, std::memory_order_relaxed);
+		entries[i].data.store(0ULL, std::memory_order_relaxed);
+	}
+}
+
+int TransitionTable::GetSize() const
+{
+	return (int) mask + 1;
+}
+
+/*********** class EvalCache ************/
+
+EvalCache::EvalCache(int size)
+	:	entries(nullptr), mask(0ULL)
+{
+	int entryCount = 1;
+	while(entryCount * 2 <= size)
+	{
+		entryCount *= 2;
+	}
+
+	entries = new EvalCacheEntry[entryCount];
+	mask = (unsigned long long) (entryCount - 1);
+	Clear();
+}
+
+EvalCache::~EvalCache()
+{
+	delete[] entries;
+	entries = nullptr;
+}
+
+void EvalCache::Clear()
+{
+	for(int i = 0; i < GetSize(); ++i)
+	{
+		entries[i].hash = 0ULL;
+		entries[i].value = 0;
+	}
+}
+
+int EvalCache::GetSize() const
+{
+	return (int) mask + 1;
+}
+
+/********* class PawnHashTable **********/
+
+PawnHashTable::PawnHashTable(int size)
+	:	entries(nullptr), mask(0ULL)
+{
+	int entryCount = 1;
+	while(entryCount * 2 <= size)
+	{
+		entryCount *= 2;
+	}
+
+	entries = new PawnStructure[entryCount];
+	mask = (unsigned long long) (entryCount - 1);
+	Clear();
+}
+
+PawnHashTable::~PawnHashTable()
+{
+	delete[] entries;
+	entries = nullptr;
+}
+
+void PawnHashTable::Clear()
+{
+	for(int i = 0; i < GetSize(); ++i)
+	{
+		entries[i].pawnHash = 0ULL;
+		entries[i].score = 0;
+		entries[i].passedPawns[Config::WHITE].Zero();
+		entries[i].passedPawns[Config::BLACK].Zero();
+	}
+}
+
+int PawnHashTable::GetSize() const
+{
+	return (int) mask + 1;
+}
+
 /*********** class AIPlayer *************/
 
 AIPlayer::AIPlayer(int depth, int iterations, Config::PlayerColour colour, RandomGenerator * gen)
-	:	Player(depth, iterations, colour), rgen(gen), transitionTable(nullptr)
+	:	Player(depth, iterations, colour), rgen(gen), transitionTable(nullptr), ownsTransitionTable(true), moveArena(nullptr), evalCache(nullptr), pawnHashTable(nullptr), searchStats(nullptr), frames(nullptr), stepped(nullptr), nodeLimit(0ULL), stopFlag(nullptr), listener(nullptr), openingBook(nullptr), tablebases(nullptr), network(nullptr)
 {
-	transitionTable = new TransitionTable(depth);
+	transitionTable = new TransitionTable();
+	moveArena = new MoveArena(Config::MAX_SEARCH_PLY);
+	evalCache = new EvalCache();
+	pawnHashTable = new PawnHashTable();
+	searchStats = new SearchStats();
+	frames = new SearchFrame[moveArena->GetPlyCount()];
+	stepped = new SteppedSearch();
+	stepped->active = false;
+	stepped->top = 0;
 }
 
 AIPlayer::~AIPlayer()
 {
-	delete transitionTable;
+	delete stepped;
+	stepped = nullptr;
+	delete[] frames;
+	frames = nullptr;
+	delete searchStats;
+	searchStats = nullptr;
+	delete pawnHashTable;
+	pawnHashTable = nullptr;
+	delete evalCache;
+	evalCache = nullptr;
+	delete moveArena;
+	moveArena = nullptr;
+	if(ownsTransitionTable)
+	{
+		delete transitionTable;
+	}
 	transitionTable = nullptr;
 }
 
@@ -58,13 +241,28 @@ Config::PlayerType AIPlayer::GetType() const
 }
 
 bool AIPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) const
+{
+	return ThinkMove(piece, pos, board, 0ULL);
+}
+
+bool AIPlayer::ThinkMove(Piece& piece, ChessVector& pos, const Board * board, unsigned long long nodes) const
 {
 	if(!board)
 		return false;
 
-	DynamicArray<Move> possibleMoves(Const::MAX_PIECES_MOVES);
+	// another position than the searched one (the next move, or the board was changed meanwhile) is searched anew
+	if(!stepped->active || stepped->rootHash != board->GetPositionHash(playerColour))
+	{
+		if(openingBook && openingBook->GetMove(*board, playerColour, rgen, piece, pos))
+		{
+			stepped->active = false;
+			printf("Book move for %s player:\n", Const::COLOUR_NAMES[playerColour].GetPtr());
+			printf("%s to (%d, %d, %d)\n\n", Const::PIECE_NAMES[piece.GetType()].GetPtr(), pos.x, pos.y, pos.z);
+			return true;
+		}
 
-	long long start = clock();
+		BeginSearch(*board, playerColour);
+	}
 
 	/* Doesnt work at the moment ****/
 	//// if we have iterative deepening
@@ -82,11 +280,14 @@ bool AIPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) cons
 	// This is needed because of the oddity reversal in the alpha-beta search
 	//int index = ((searchDepth & 1) != 0 ? 0 : possibleMoves.Count() - 1);
 
-	Move finalMove = AlphaBetaSingle(*board, searchDepth, playerColour); //possibleMoves[index];
+	if(!StepSearch(nodes))
+		return false;
+
+	Move finalMove = stepped->bestMove; //possibleMoves[index];
 	
 	long long end = clock();
 
-	float calculation = (float)(end - start)/ CLOCKS_PER_SEC;
+	float calculation = (float)(end - stepped->startClock)/ CLOCKS_PER_SEC;
 
 	int ms = (calculation - floor( calculation)) * 1000;
 	int second = floor( calculation);
@@ -94,12 +295,19 @@ bool AIPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) cons
 	int min = (second / 60) % 60;
 	int hrs = second / 3600;
 
-	printf("Calculation time : %dh %dm %d.%ds\n", hrs, min, sec, ms);
+	printf("Calculation time : %dh %dm %d.%ds, depth : %d\n", hrs, min, sec, ms, searchStats->depth);
+	printf("Nodes : %llu, transition table cutoffs : %.1f%%, eval cache hits : %.1f%%, pawn hash hits : %.1f%%\n", searchStats->nodes,
+		searchStats->GetHashHitRate(), searchStats->GetEvalHitRate(), searchStats->GetPawnHitRate());
 
 	//finalMove = GetRandomBestMove(possibleMoves);
 
 	printf("Best ai move heuristics for %s player:\n", Const::COLOUR_NAMES[playerColour].GetPtr());
 	printf("%s to (%d, %d, %d), h = %d\n", Const::PIECE_NAMES[finalMove.piece.GetType()].GetPtr(), finalMove.destination.x, finalMove.destination.y, finalMove.destination.z, finalMove.heuristic);
+	if(Utils::Abs(finalMove.heuristic) > Config::MATE_THRESHOLD)
+	{
+		const int matePlies = Config::MATE_SCORE - Utils::Abs(finalMove.heuristic);
+		printf("%s in %d moves\n", (finalMove.heuristic > 0 ? "Mates" : "Is mated"), (matePlies + 1) / 2);
+	}
 	/*for(int i = 0; i < possibleMoves.Count(); ++i)
 	{
 		printf("%s to (%d, %d, %d), h = %d\n", Const::PIECE_NAMES[possibleMoves[i].piece.GetType()].GetPtr(), possibleMoves[i].destination.x, possibleMoves[i].destination.y, possibleMoves[i].destination.z, possibleMoves[i].heuristic);
@@ -112,6 +320,144 @@ bool AIPlayer::GetMove(Piece& piece, ChessVector& pos, const Board * board) cons
 	return true;
 }
 
+Move AIPlayer::Search(const Board& board, Config::PlayerColour colour) const
+{
+	return AlphaBetaSingle(board, searchDepth, colour);
+}
+
+Move AIPlayer::Search(const Board& board, Config::PlayerColour colour, int depth, const DynamicArray<Move>& searchMoves) const
+{
+	return AlphaBetaSingle(board, Utils::Max(1, Utils::Min(depth, Config::MAX_SEARCH_PLY - 1)), colour, searchMoves.Count() ? &searchMoves : nullptr);
+}
+
+void AIPlayer::SetOpeningBook(const OpeningBook * book)
+{
+	openingBook = book;
+}
+
+void AIPlayer::SetTablebases(const Tablebases * tables)
+{
+	tablebases = tables;
+}
+
+void AIPlayer::SetNetwork(const NnueNetwork * net)
+{
+	network = (net && net->IsLoaded() ? net : nullptr);
+	// the cached evaluations and search scores are from the previous evaluation function
+	evalCache->Clear();
+	transitionTable->Clear();
+}
+
+void AIPlayer::SetNodeLimit(unsigned long long nodes)
+{
+	nodeLimit = nodes;
+}
+
+void AIPlayer::SetStopFlag(const std::atomic<bool> * stop)
+{
+	stopFlag = stop;
+}
+
+void AIPlayer::SetSearchListener(SearchListener * searchListener)
+{
+	listener = searchListener;
+}
+
+void AIPlayer::NewGame()
+{
+	transitionTable->Clear();
+	evalCache->Clear();
+	pawnHashTable->Clear();
+}
+
+void AIPlayer::SetEvalCacheSize(int size)
+{
+	delete evalCache;
+	evalCache = new EvalCache(size);
+}
+
+void AIPlayer::SetTransitionTableSize(int size)
+{
+	if(ownsTransitionTable)
+	{
+		delete transitionTable;
+	}
+	transitionTable = new TransitionTable(size);
+	ownsTransitionTable = true;
+}
+
+void AIPlayer::SetSharedTransitionTable(TransitionTable * table)
+{
+	if(ownsTransitionTable)
+	{
+		delete transitionTable;
+	}
+	transitionTable = table;
+	ownsTransitionTable = false;
+}
+
+const SearchStats& AIPlayer::GetSearchStats() const
+{
+	return *searchStats;
+}
+
+void AIPlayer::BeginSearch(const Board& board, Config::PlayerColour colour) const
+{
+	StartSearch(board, searchDepth, colour, nullptr);
+}
+
+bool AIPlayer::StepSearch(unsigned long long nodes) const
+{
+	if(!stepped->active)
+		return true;
+
+	const unsigned long long stepEnd = (nodes ? searchStats->nodes + nodes : ~0ULL);
+	int score = 0;
+	while(RunFrames(stepped->board, 0, stepped->top, stepEnd, score))
+	{
+		// the move of the last finished depth is played
+		if(searchStats->aborted)
+		{
+			stepped->active = false;
+			return true;
+		}
+
+		stepped->bestMove = moveArena->GetMoves(0)[0];
+		searchStats->depth = stepped->iterationDepth;
+
+		if(listener)
+		{
+			SearchInfo info;
+			info.depth = stepped->iterationDepth;
+			info.score = stepped->bestMove.heuristic;
+			info.nodes = searchStats->nodes;
+			GetPrincipalVariation(stepped->board, stepped->colour, stepped->bestMove, stepped->iterationDepth, info.pv);
+			listener->OnDepthFinished(info);
+		}
+
+		if(stepped->iterationDepth >= stepped->depth)
+		{
+			stepped->active = false;
+			return true;
+		}
+
+		stepped->iterationDepth++;
+		PushRootFrame(stepped->iterationDepth, stepped->colour, 0);
+		stepped->top = 0;
+	}
+	return false;
+}
+
+Move AIPlayer::GetSearchResult() const
+{
+	return stepped->bestMove;
+}
+
+bool AIPlayer::IsSearching() const
+{
+	return stepped->active;
+}
+
 void AIPlayer::IterateAlphaBetaRoot(const Board& board, int iteration, DynamicArray<Move>& generatedMoves) const
 {
 	// first the end of the recursion
@@ -141,7 +487,7 @@ void AIPlayer::IterateAlphaBetaRoot(const Board& board, int iteration, DynamicAr
 			// make the move and start an Alpha Beta from it
 			MadeMove move = boardCopy.MovePiece(generatedMoves[i].piece, generatedMoves[i].destination, generatedMoves[i].pieceMoves, true);
 
-			int alphaBetaResult = AlphaBeta(boardCopy, searchDepth + iteration * 2, Config::INT_NEGATIVE_INFINITY, Config::INT_POSITIVE_INFINITY, false, oppositeColour);
+			int alphaBetaResult = - AlphaBeta(boardCopy, searchDepth + iteration * 2, 1, - Config::SEARCH_INFINITY, Config::SEARCH_INFINITY, oppositeColour);
 
 			boardCopy.UndoMove(move);
 
@@ -153,53 +499,146 @@ void AIPlayer::IterateAlphaBetaRoot(const Board& board, int iteration, DynamicAr
 	}
 }
 
-Move AIPlayer::AlphaBetaSingle(const Board& board, int depth, Config::PlayerColour colour) const
+Move AIPlayer::AlphaBetaSingle(const Board& board, int depth, Config::PlayerColour colour, const DynamicArray<Move> * searchMoves) const
 {
-	Board boardCopy(board);
-
-	DynamicArray<Move> availableMoves(Const::MAX_PIECES_MOVES);
+	// the blocking search is the stepped one in a single step, so both find the same moves
+	StartSearch(board, depth, colour, searchMoves);
+	StepSearch(0ULL);
+	return stepped->bestMove;
+}
 
-	// first fill with some expected heuristic
-	boardCopy.GetPossibleMoves(colour, availableMoves);
-	for(int i = 0; i < availableMoves.Count(); ++i)
+void AIPlayer::StartSearch(const Board& board, int depth, Config::PlayerColour colour, const DynamicArray<Move> * searchMoves) const
+{
+	stepped->board = board;
+	stepped->board.SetNetwork(network);
+	stepped->colour = colour;
+	stepped->rootHash = board.GetPositionHash(colour);
+	stepped->depth = depth;
+	stepped->startClock = clock();
+	stepped->active = false;
+	searchStats->Clear();
+
+	DynamicArray<Move>& availableMoves = moveArena->GetPlyMoves(0);
+	GetRootMoves(stepped->board, colour, availableMoves);
+	if(searchMoves)
+	{
+		for(int i = availableMoves.Count() - 1; i >= 0; --i)
+		{
+			bool searched = false;
+			for(int j = 0; j < searchMoves->Count() && !searched; ++j)
+			{
+				searched = (*searchMoves)[j].piece.GetPositionCoord() == availableMoves[i].piece.GetPositionCoord()
+					&& (*searchMoves)[j].destination.GetVectorCoord() == availableMoves[i].destination.GetVectorCoord();
+			}
+			if(!searched)
+				availableMoves.RemoveItem(i);
+		}
+		// the removal mixed the order of the moves
+		availableMoves.Sort();
+	}
+	if(availableMoves.Count() == 0)
 	{
-		availableMoves[i].heuristic = MoveHeuristic(availableMoves[i], board);
+		stepped->bestMove = Move();
+		return;
 	}
 
-	// sort the moves so that the most valuable are first
-	availableMoves.Sort();
-
-	Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	// an interrupted search is deepened until it is stopped, the move of the last finished depth is played
+	stepped->iterative = (nodeLimit || stopFlag || listener);
+	stepped->iterationDepth = (stepped->iterative ? 1 : depth);
+	stepped->bestMove = availableMoves[0];
+	stepped->active = true;
+	PushRootFrame(stepped->iterationDepth, colour, 0);
+	stepped->top = 0;
+}
 
-	BitBoard playerPieces = board.GetPiecesBitBoard(colour);
-	BitBoard enemyPieces = board.GetPiecesBitBoard(oppositeColour);
+void AIPlayer::Analyse(const Board& board, Config::PlayerColour colour, int lineCount, DynamicArray<AnalysisLine>& lines) const
+{
+	// the analysis reuses the move buffers of the stepped search
+	stepped->active = false;
+	Board boardCopy(board);
+	boardCopy.SetNetwork(network);
+	searchStats->Clear();
+	lines.Clear();
 
-	int alpha = Config::INT_NEGATIVE_INFINITY;
-	Move bestMove = availableMoves.Count() > 0 ? availableMoves[0] : Move();
+	DynamicArray<Move>& rootMoves = moveArena->GetPlyMoves(0);
+	GetRootMoves(boardCopy, colour, rootMoves);
 
-	printf("Moves Count: %d\n", availableMoves.Count());
+	// the previous lines are in front of the root moves, so every pass searches only the rest
+	lineCount = Utils::Min(lineCount, rootMoves.Count());
+	for(int line = 0; line < lineCount; ++line)
+	{
+		AnalysisLine result;
+		result.score = SearchRoot(boardCopy, searchDepth, colour, line);
+		// the node budget ends the analysis with the lines finished so far
+		if(searchStats->aborted)
+			break;
+		GetPrincipalVariation(boardCopy, colour, rootMoves[line], searchDepth, result.moves);
+		lines += result;
+	}
+}
 
-	for(int i = 0; i < availableMoves.Count(); ++i)
+void AIPlayer::GetRootMoves(Board& board, Config::PlayerColour colour, DynamicArray<Move>& rootMoves) const
+{
+	// first fill with some expected heuristic
+	board.GetPossibleMoves(colour, rootMoves);
+	for(int i = 0; i < rootMoves.Count(); ++i)
 	{
-		// make the move and start an Alpha Beta from it
-		MadeMove move = boardCopy.MovePiece(availableMoves[i].piece, availableMoves[i].destination, availableMoves[i].pieceMoves, true);
+		rootMoves[i].heuristic = MoveHeuristic(rootMoves[i], board);
+	}
 
-		int alphaBetaResult = AlphaBeta(boardCopy, depth - 1, alpha, Config::INT_POSITIVE_INFINITY, false, oppositeColour);
+	// sort the moves so that the most valuable are first
+	rootMoves.Sort();
+}
 
-		boardCopy.UndoMove(move);
+int AIPlayer::SearchRoot(Board& board, int depth, Config::PlayerColour colour, int firstMove) const
+{
+	PushRootFrame(depth, colour, firstMove);
+	int top = 0;
+	int score = 0;
+	RunFrames(board, 0, top, ~0ULL, score);
+	return score;
+}
 
-		if(alphaBetaResult > alpha)
-		{
-			alpha = alphaBetaResult;
-			bestMove = availableMoves[i];
-			bestMove.heuristic = alpha;
-		}
-	}
+void AIPlayer::PushRootFrame(int depth, Config::PlayerColour colour, int firstMove) const
+{
+	SearchFrame& frame = frames[0];
+	frame.depth = depth;
+	frame.alpha = - Config::SEARCH_INFINITY;
+	frame.beta = Config::SEARCH_INFINITY;
+	frame.colour = colour;
+	frame.positionHash = 0ULL;
+	frame.moveIndex = firstMove;
+	frame.bestIndex = firstMove;
+	frame.firstMove = firstMove;
+	frame.root = true;
+}
 
-	// clear the transition table, it will not help us later
-	//transitionTable->Clear();
+void AIPlayer::GetPrincipalVariation(Board& board, Config::PlayerColour colour, const Move& move, int maxLength, DynamicArray<Move>& pv) const
+{
+	DynamicArray<MadeMove> madeMoves(maxLength);
+	pv.Clear();
+	pv += move;
+	madeMoves += board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+	colour = Config::GetOppositePlayer(colour);
+
+	// the table entries may be overwritten by other positions, so every move is validated before it is made
+	TransitionEntry entry;
+	while(pv.Count() < maxLength && !board.IsRepetition() && transitionTable->GetEntry(board.GetPositionHash(colour), entry) && entry.source >= 0)
+	{
+		const Piece piece = board.GetPiece(ChessVector(entry.source));
+		const ChessVector destination(entry.destination);
+		if(piece.GetType() == Config::NO_TYPE || piece.GetColour() != colour || !board.ValidMove(piece, destination))
+			break;
+
+		pv += Move(piece, destination, BitBoard(), entry.score);
+		madeMoves += board.MovePiece(piece, destination, true);
+		colour = Config::GetOppositePlayer(colour);
+	}
 
-	return bestMove;
+	for(int i = madeMoves.Count() - 1; i >= 0; --i)
+	{
+		board.UndoMove(madeMoves[i]);
+	}
 }
 
 void AIPlayer::AlphaBetaRoot(const Board& board, Config::PlayerColour colour, DynamicArray<Move>& generatedMoves) const
@@ -226,7 +665,7 @@ void AIPlayer::AlphaBetaRoot(const Board& board, Config::PlayerColour colour, Dy
 		// make the move and start an Alpha Beta from it
 		MadeMove move = boardCopy.MovePiece(generatedMoves[i].piece, generatedMoves[i].destination, generatedMoves[i].pieceMoves, true);
 
-		int alphaBetaResult = AlphaBeta(boardCopy, searchDepth, Config::INT_NEGATIVE_INFINITY, Config::INT_POSITIVE_INFINITY, false, oppositeColour);
+		int alphaBetaResult = - AlphaBeta(boardCopy, searchDepth, 1, - Config::SEARCH_INFINITY, Config::SEARCH_INFINITY, oppositeColour);
 
 		boardCopy.UndoMove(move);
 
@@ -237,80 +676,284 @@ void AIPlayer::AlphaBetaRoot(const Board& board, Config::PlayerColour colour, Dy
 	//transitionTable->Clear();
 }
 
-int AIPlayer::AlphaBeta(Board& board, int depth, int alpha, int beta, bool maximizing, Config::PlayerColour colour) const
+int AIPlayer::AlphaBeta(Board& board, int depth, int ply, int alpha, int beta, Config::PlayerColour colour) const
+{
+	int score = 0;
+	if(EnterNode(board, depth, ply, alpha, beta, colour, score))
+		return score;
+
+	int top = ply;
+	RunFrames(board, ply, top, ~0ULL, score);
+	return score;
+}
+
+bool AIPlayer::EnterNode(Board& board, int depth, int ply, int alpha, int beta, Config::PlayerColour colour, int& value) const
 {
-	if(depth <= 0)
+	searchStats->nodes++;
+
+	// the score of an aborted search is never used
+	if((nodeLimit && searchStats->nodes > nodeLimit) || (stopFlag && stopFlag->load(std::memory_order_relaxed)))
+	{
+		searchStats->aborted = true;
+		value = 0;
+		return true;
+	}
+
+	// the players can repeat the cycle forever, so a repeated position is a draw for both of them
+	if(board.IsRepetition())
+	{
+		value = 0;
+		return true;
+	}
+
+	// mate distance pruning - neither a mate closer to the root than this ply nor being mated before it is possible here
+	alpha = Utils::Max(alpha, - Config::MATE_SCORE + ply);
+	beta = Utils::Min(beta, Config::MATE_SCORE - ply - 1);
+	if(alpha >= beta)
+	{
+		value = alpha;
+		return true;
+	}
+
+	if(tablebases && board.GetPieceCount() <= tablebases->GetMaxPieces() && tablebases->Probe(board, colour, value))
 	{
-		return board.GetMaterialBalance() * (colour == Config::WHITE ? 1 : -1);
+		return true;
 	}
 
-	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	// the leaves are not stored in the transition table, their evaluations are in the evaluation cache
+	if(depth <= 0 || ply >= moveArena->GetPlyCount())
+	{
+		value = Evaluate(board) * (colour == Config::WHITE ? 1 : -1);
+		return true;
+	}
+
+	const unsigned long long positionHash = board.GetPositionHash(colour);
+	TransitionEntry entry;
+	coord hashSource = -1;
+	coord hashDestination = -1;
+	searchStats->hashProbes++;
+	if(transitionTable->GetEntry(positionHash, entry))
+	{
+		hashSource = entry.source;
+		hashDestination = entry.destination;
+		if(entry.depth >= depth)
+		{
+			const int score = ScoreFromTable(entry.score, ply);
+			if(entry.bound == BOUND_EXACT
+				|| (entry.bound == BOUND_LOWER && score >= beta)
+				|| (entry.bound == BOUND_UPPER && score <= alpha))
+			{
+				searchStats->hashHits++;
+				value = score;
+				return true;
+			}
+		}
+	}
+
+	DynamicArray<Move>& moves = moveArena->GetPlyMoves(ply);
 	board.GetPossibleMoves(colour, moves);
+
+	// without moves the player is either mated (the sooner the worse) or it is a stalemate
+	if(moves.Count() == 0)
+	{
+		value = board.KingInCheck(colour) ? - Config::MATE_SCORE + ply : 0;
+		return true;
+	}
+
+	// the best move of the previous search of this position goes first
 	for(int i = 0; i < moves.Count(); ++i)
 	{
-		moves[i].heuristic = MoveHeuristic(moves[i], board);
+		if(moves[i].piece.GetPositionCoord() == hashSource && moves[i].destination.GetVectorCoord() == hashDestination)
+			moves[i].heuristic = Config::INT_POSITIVE_INFINITY;
+		else
+			moves[i].heuristic = MoveHeuristic(moves[i], board);
 	}
 
 	// sort the moves so that the most valuable are first
 	moves.Sort();
 
-	Config::PlayerColour oppositePlayer = Config::GetOppositePlayer(colour);
-
-	BitBoard playerPieces = board.GetPiecesBitBoard(colour);
-	BitBoard enemyPieces = board.GetPiecesBitBoard(oppositePlayer);
+	SearchFrame& frame = frames[ply];
+	frame.depth = depth;
+	frame.alpha = alpha;
+	frame.beta = beta;
+	frame.colour = colour;
+	frame.positionHash = positionHash;
+	frame.moveIndex = 0;
+	frame.bestIndex = -1;
+	frame.firstMove = 0;
+	frame.root = false;
+	return false;
+}
 
-	if(maximizing)
+bool AIPlayer::RunFrames(Board& board, int base, int& top, unsigned long long stepEnd, int& value) const
+{
+	for(;;)
 	{
-		unsigned long long boardHash = 0ULL;
-		for(int i = 0; i < moves.Count(); ++i)
+		SearchFrame& frame = frames[top];
+		const DynamicArray<Move>& moves = moveArena->GetMoves(top);
+		if(frame.moveIndex < moves.Count() && frame.alpha < frame.beta)
 		{
-			MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
-
-			boardHash = board.GetHash();
-
-			int res = 0;
-			/*if(!transitionTable->GetValue(depth - 1, boardHash, res))
-			{*/
-				res = AlphaBeta(board, depth - 1, alpha, beta, false, oppositePlayer);
+			// the step ends between two nodes, the next one continues with the same move
+			if(searchStats->nodes >= stepEnd)
+				return false;
 
-				/*transitionTable->AddValue(depth - 1, boardHash, res);
-			}*/
+			const Move& move = moves[frame.moveIndex];
+			frame.madeMove = board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+			if(!EnterNode(board, frame.depth - 1, top + 1, - frame.beta, - frame.alpha, Config::GetOppositePlayer(frame.colour), value))
+			{
+				top++;
+				continue;
+			}
+		}
+		else
+		{
+			value = FinishFrame(frame, top);
+			if(top == base)
+				return true;
+			top--;
+		}
 
-			board.UndoMove(move);
+		// the child score returns to the frame on the top
+		SearchFrame& parent = frames[top];
+		board.UndoMove(parent.madeMove);
 
-			alpha = Utils::Max(alpha, res);
-			if( beta <= alpha)
+		// the unfinished scores must not get in the transition table (nor the root moves), the moves below are undone too
+		if(searchStats->aborted)
+		{
+			value = (frames[base].root ? frames[base].alpha : 0);
+			while(top > base)
 			{
-				break;
+				top--;
+				board.UndoMove(frames[top].madeMove);
 			}
+			return true;
+		}
+
+		const int res = - value;
+		if(res > parent.alpha)
+		{
+			parent.alpha = res;
+			parent.bestIndex = parent.moveIndex;
 		}
-		return alpha;
+		parent.moveIndex++;
+	}
+}
+
+int AIPlayer::FinishFrame(const SearchFrame& frame, int ply) const
+{
+	DynamicArray<Move>& moves = moveArena->GetMoves(ply);
+	if(frame.root)
+	{
+		Move bestMove = moves[frame.bestIndex];
+		bestMove.heuristic = frame.alpha;
+		moves[frame.bestIndex] = moves[frame.firstMove];
+		moves[frame.firstMove] = bestMove;
+		return frame.alpha;
+	}
+
+	const TransitionBound bound = (frame.alpha >= frame.beta ? BOUND_LOWER : (frame.bestIndex >= 0 ? BOUND_EXACT : BOUND_UPPER));
+	if(frame.bestIndex >= 0)
+	{
+		transitionTable->AddEntry(frame.positionHash, frame.depth, ScoreToTable(frame.alpha, ply), bound, moves[frame.bestIndex].piece.GetPositionCoord(), moves[frame.bestIndex].destination.GetVectorCoord());
 	}
 	else
 	{
-		unsigned long long boardHash = 0ULL;
-		for(int i = 0; i < moves.Count(); ++i)
+		transitionTable->AddEntry(frame.positionHash, frame.depth, ScoreToTable(frame.alpha, ply), bound, -1, -1);
+	}
+	return frame.alpha;
+}
+
+int AIPlayer::FindMate(const Board& board, Config::PlayerColour colour, int maxMoves, Move& mateMove) const
+{
+	// the mate search reuses the move buffers of the stepped search
+	stepped->active = false;
+	Board boardCopy(board);
+	// the mate search doesn't evaluate, so the network doesn't have to be updated
+	boardCopy.SetNetwork(nullptr);
+	searchStats->Clear();
+
+	DynamicArray<Move>& rootMoves = moveArena->GetPlyMoves(0);
+	boardCopy.GetPossibleMoves(colour, rootMoves);
+	for(int i = 0; i < rootMoves.Count(); ++i)
+	{
+		rootMoves[i].heuristic = MoveHeuristic(rootMoves[i], boardCopy);
+	}
+	rootMoves.Sort();
+
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	maxMoves = Utils::Min(maxMoves, moveArena->GetPlyCount() / 2);
+
+	// the mates are searched from the shortest, so the first found is the fastest one
+	for(int mateMoves = 1; mateMoves <= maxMoves; ++mateMoves)
+	{
+		for(int i = 0; i < rootMoves.Count(); ++i)
 		{
-			MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
+			MadeMove move = boardCopy.MovePiece(rootMoves[i].piece, rootMoves[i].destination, rootMoves[i].pieceMoves, true);
+			searchStats->nodes++;
+
+			const bool mate = boardCopy.KingInCheck(oppositeColour) && MateSearch(boardCopy, mateMoves * 2 - 2, 1, oppositeColour);
+
+			boardCopy.UndoMove(move);
+
+			if(mate)
+			{
+				mateMove = rootMoves[i];
+				mateMove.heuristic = Config::MATE_SCORE - (mateMoves * 2 - 1);
+				return mateMoves;
+			}
+		}
+	}
+	return 0;
+}
 
-			boardHash = board.GetHash();
+bool AIPlayer::MateSearch(Board& board, int depth, int ply, Config::PlayerColour colour) const
+{
+	searchStats->nodes++;
+
+	const bool attacking = (depth & 1) != 0;
 
-			int res = 0;
-			/*if(!transitionTable->GetValue(depth - 1, boardHash, res))
-			{*/
-				res = AlphaBeta(board, depth - 1, alpha, beta, true, oppositePlayer);
+	// the attacker plays only checks, so the defender without moves is mated
+	// in the last ply only that is left to decide, so the moves are not generated there
+	if(!attacking && depth == 0)
+		return !board.HasLegalMove(colour);
 
-			/*	transitionTable->AddValue(depth - 1, boardHash, res);
-			}*/
+	DynamicArray<Move>& moves = moveArena->GetPlyMoves(ply);
+	board.GetPossibleMoves(colour, moves);
 
-			board.UndoMove(move);
+	if(!attacking && moves.Count() == 0)
+		return true;
 
-			beta = Utils::Min(beta, res);
-			if(beta <= alpha)
-				break;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		moves[i].heuristic = MoveHeuristic(moves[i], board);
+	}
+	moves.Sort();
+
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
+
+		bool mate = false;
+		if(attacking)
+		{
+			// the repeated checks only lead back to the already searched positions
+			mate = board.KingInCheck(oppositeColour) && !board.IsRepetition() && MateSearch(board, depth - 1, ply + 1, oppositeColour);
 		}
-		return beta;
+		else
+		{
+			mate = MateSearch(board, depth - 1, ply + 1, oppositeColour);
+		}
+
+		board.UndoMove(move);
+
+		// one mating move is enough for the attacker, one escape is enough for the defender
+		if(mate == attacking)
+			return attacking;
 	}
+
+	return !attacking;
 }
 
 Move AIPlayer::GetRandomBestMove(DynamicArray<Move>& moves) const
@@ -319,9 +962,9 @@ Move AIPlayer::GetRandomBestMove(DynamicArray<Move>& moves) const
 	
 	DynamicArray<Move> bestCandidates;
 
-	// this is necessary because of the oddity changes from the AlphaBeta algorithm
-	const int startingIndex = (searchDepth & 1 ? 0 : moves.Count() - 1);
-	int incrementation = (searchDepth & 1 ? 1 : -1);
+	// the scores are for the player on move, so the best moves are first
+	const int startingIndex = 0;
+	int incrementation = 1;
 
 	bool inThreshold = true;
 	
@@ -358,4 +1001,38 @@ Move AIPlayer::GetRandomBestMove(DynamicArray<Move>& moves) const
 int AIPlayer::MoveHeuristic(const Move& move, const Board& board) const
 {	
 	return move.piece.GetPositionWorth(move.destination) + board.GetPiece(move.destination).GetWorth();
+}
+
+int AIPlayer::Evaluate(const Board& board) const
+{
+	searchStats->evalProbes++;
+
+	// the balance doesn't depend on the player on move, so the board hash is enough
+	const unsigned long long hash = board.GetHash();
+	int value = 0;
+	if(evalCache->GetValue(hash, value))
+	{
+		searchStats->evalHits++;
+		return value;
+	}
+
+	if(board.GetNetwork())
+	{
+		assert(board.VerifyAccumulator());
+		value = board.GetNetwork()->Evaluate(board.GetAccumulator());
+		evalCache->AddValue(hash, value);
+		return value;
+	}
+
+	bool pawnsFound = false;
+	const PawnStructure& pawnStructure = pawnHashTable->GetStructure(board, pawnsFound);
+	searchStats->pawnProbes++;
+	if(pawnsFound)
+	{
+		searchStats->pawnHits++;
+	}
+
+	value = board.GetMaterialBalance() + pawnStructure.score;
+	evalCache->AddValue(hash, value);
+	return value;
 }
\ No newline at end of file
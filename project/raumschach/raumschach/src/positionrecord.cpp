@@ -0,0 +1,159 @@
+#include "positionrecord.h"
+#include "board.h"
+#include <string.h>
+
+bool PositionRecord::FromBoard(const Board& board, Config::PlayerColour toMove)
+{
+	if(board.GetPieceCount() > Config::POSITION_RECORD_MAX_PIECES)
+		return false;
+
+	int count = 0;
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		const DynamicArray<Piece>& colourPieces = board.GetPieces((Config::PlayerColour) colour);
+		for(int i = 0; i < colourPieces.Count(); ++i)
+		{
+			pieces[count++] = colourPieces[i];
+		}
+	}
+	for(; count < Config::POSITION_RECORD_MAX_PIECES; ++count)
+	{
+		pieces[count] = Piece();
+	}
+
+	colourToMove = (unsigned char) toMove;
+	return true;
+}
+
+void PositionRecord::ToBoard(Board& board) const
+{
+	board.Clear();
+	for(int i = 0; i < Config::POSITION_RECORD_MAX_PIECES; ++i)
+	{
+		if(pieces[i].GetType() != Config::NO_TYPE)
+		{
+			board.AddPiece(pieces[i]);
+		}
+	}
+}
+
+/****** class PositionRecordReader ******/
+
+PositionRecordReader::PositionRecordReader()
+	:	input(nullptr)
+{}
+
+PositionRecordReader::~PositionRecordReader()
+{
+	Close();
+}
+
+bool PositionRecordReader::Open(const char * filename)
+{
+	Close();
+	input = fopen(filename, "rb");
+	if(!input)
+		return false;
+
+	char magic[sizeof(Config::POSITION_RECORD_MAGIC)];
+	if(fread(magic, sizeof(magic), 1, input) != 1 || memcmp(magic, Config::POSITION_RECORD_MAGIC, sizeof(magic)) != 0)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void PositionRecordReader::Close()
+{
+	if(input)
+	{
+		fclose(input);
+		input = nullptr;
+	}
+}
+
+int PositionRecordReader::Read(PositionRecord * records, int count)
+{
+	if(!input)
+		return 0;
+	return (int) fread(records, sizeof(PositionRecord), count, input);
+}
+
+/****** class PositionRecordWriter ******/
+
+PositionRecordWriter::PositionRecordWriter()
+	:	output(nullptr), buffer(nullptr), bufferCount(0)
+{
+	buffer = new PositionRecord[Config::POSITION_RECORD_BUFFER];
+}
+
+PositionRecordWriter::~PositionRecordWriter()
+{
+	Close();
+	delete[] buffer;
+	buffer = nullptr;
+}
+
+bool PositionRecordWriter::Open(const char * filename, bool append)
+{
+	Close();
+
+	if(append)
+	{
+		// an existing file must be a positions file, a missing one is created
+		PositionRecordReader reader;
+		FILE * existing = fopen(filename, "rb");
+		if(existing)
+		{
+			fclose(existing);
+			if(!reader.Open(filename))
+				return false;
+			reader.Close();
+			output = fopen(filename, "ab");
+			return output != nullptr;
+		}
+	}
+
+	output = fopen(filename, "wb");
+	if(!output)
+		return false;
+
+	if(fwrite(Config::POSITION_RECORD_MAGIC, sizeof(Config::POSITION_RECORD_MAGIC), 1, output) != 1)
+	{
+		fclose(output);
+		output = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void PositionRecordWriter::Close()
+{
+	if(output)
+	{
+		Flush();
+		fclose(output);
+		output = nullptr;
+	}
+}
+
+void PositionRecordWriter::Write(const PositionRecord& record)
+{
+	buffer[bufferCount++] = record;
+	if(bufferCount == Config::POSITION_RECORD_BUFFER)
+	{
+		Flush();
+	}
+}
+
+bool PositionRecordWriter::Flush()
+{
+	bool written = true;
+	if(output && bufferCount > 0)
+	{
+		written = fwrite(buffer, sizeof(PositionRecord), bufferCount, output) == (size_t) bufferCount;
+	}
+	bufferCount = 0;
+	return written;
+}
@@ -0,0 +1,340 @@
+#include "configuration.h"
+#include "constants.h"
+#include "proofsearch.h"
+#include "notation.h"
+
+namespace
+{
+	// the proof and disproof numbers of the solved nodes, the sums of the unsolved ones stay below it
+	const unsigned PROOF_INFINITY = 1u << 30;
+
+	inline unsigned AddProof(unsigned a, unsigned b)
+	{
+		if(a >= PROOF_INFINITY || b >= PROOF_INFINITY)
+			return PROOF_INFINITY;
+		return Utils::Min(a + b, PROOF_INFINITY - 1);
+	}
+}
+
+ProofNumberSearch::ProofNumberSearch(int nodeCount)
+	:	nodes(nullptr), capacity(nodeCount), freeList(-1), untouchedNodes(0), usedNodes(0), peakNodes(0), board(), rootColour(Config::WHITE), maxPlies(0), expanded(0ULL),
+		moves(Const::MAX_PIECES_MOVES), replies(Const::MAX_PIECES_MOVES)
+{
+	nodes = new ProofNode[capacity];
+}
+
+ProofNumberSearch::~ProofNumberSearch()
+{
+	delete[] nodes;
+	nodes = nullptr;
+}
+
+ProofResult ProofNumberSearch::Solve(const Board& source, Config::PlayerColour colour, int maxMoves)
+{
+	board = source;
+	// the search doesn't evaluate, so the network doesn't have to be updated
+	board.SetNetwork(nullptr);
+	rootColour = colour;
+	maxMoves = Utils::Max(1, Utils::Min(maxMoves, Config::MAX_SEARCH_PLY / 2));
+	maxPlies = maxMoves * 2 - 1;
+	expanded = 0ULL;
+
+	freeList = -1;
+	untouchedNodes = 0;
+	usedNodes = 0;
+	peakNodes = 0;
+
+	const int root = AllocateNode(-1, -1, -1);
+	MadeMove madeMoves[Config::MAX_SEARCH_PLY];
+	int current = root;
+	int ply = 0;
+	ProofResult result = PROOF_UNKNOWN;
+
+	while(nodes[root].proof != 0 && nodes[root].disproof != 0)
+	{
+		// the most proving node - the attacker's easiest child to prove, the defender's easiest child to disprove
+		while(nodes[current].expanded)
+		{
+			const bool attacking = (ply & 1) == 0;
+			int child = nodes[current].firstChild;
+			while(attacking ? nodes[child].proof != nodes[current].proof : nodes[child].disproof != nodes[current].disproof)
+			{
+				child = nodes[child].nextSibling;
+			}
+			madeMoves[ply++] = board.MovePiece(board.GetPiece(ChessVector(nodes[child].source)), ChessVector(nodes[child].destination), BitBoard(), true);
+			current = child;
+		}
+
+		if(!Expand(current, ply, (ply & 1) == 0))
+			break;
+
+		// the numbers go up while they change, the next selection starts from the first unchanged node
+		for(;;)
+		{
+			const bool attacking = (ply & 1) == 0;
+			const unsigned proof = nodes[current].proof;
+			const unsigned disproof = nodes[current].disproof;
+			Update(current, attacking);
+			if(nodes[current].proof == 0 || nodes[current].disproof == 0)
+			{
+				CollectGarbage(current, attacking);
+			}
+
+			if(current == root || (proof == nodes[current].proof && disproof == nodes[current].disproof))
+				break;
+
+			current = nodes[current].parent;
+			board.UndoMove(madeMoves[--ply]);
+		}
+	}
+
+	while(ply > 0)
+	{
+		board.UndoMove(madeMoves[--ply]);
+	}
+
+	if(nodes[root].proof == 0)
+		result = PROOF_PROVED;
+	else if(nodes[root].disproof == 0)
+		result = PROOF_DISPROVED;
+	return result;
+}
+
+Move ProofNumberSearch::GetProofMove() const
+{
+	// the garbage collection leaves only the proving child of the proved root
+	if(usedNodes == 0 || nodes[0].proof != 0 || nodes[0].firstChild < 0)
+		return Move();
+
+	const ProofNode& child = nodes[nodes[0].firstChild];
+	// the moves of the proof are legal, so the move bitboard is not needed
+	return Move(board.GetPiece(ChessVector(child.source)), ChessVector(child.destination), BitBoard(), Config::MATE_SCORE - GetProofDepth(0));
+}
+
+int ProofNumberSearch::GetMateMoves() const
+{
+	if(usedNodes == 0 || nodes[0].proof != 0)
+		return 0;
+	return (GetProofDepth(0) + 1) / 2;
+}
+
+void ProofNumberSearch::PrintProofTree(FILE * output) const
+{
+	if(usedNodes == 0 || nodes[0].proof != 0)
+		return;
+
+	for(int child = nodes[0].firstChild; child >= 0; child = nodes[child].nextSibling)
+	{
+		PrintNode(output, child, 0);
+	}
+}
+
+unsigned long long ProofNumberSearch::GetExpandedCount() const
+{
+	return expanded;
+}
+
+int ProofNumberSearch::GetPeakNodes() const
+{
+	return peakNodes;
+}
+
+int ProofNumberSearch::AllocateNode(int parent, coord source, coord destination)
+{
+	// the freed nodes are reused first, the table is taken from its start only when they run out
+	int index = freeList;
+	if(index >= 0)
+		freeList = nodes[index].nextSibling;
+	else if(untouchedNodes < capacity)
+		index = untouchedNodes++;
+	else
+		return -1;
+	usedNodes++;
+	peakNodes = Utils::Max(peakNodes, usedNodes);
+
+	ProofNode& node = nodes[index];
+	node.proof = 1;
+	node.disproof = 1;
+	node.parent = parent;
+	node.firstChild = -1;
+	node.nextSibling = -1;
+	node.source = source;
+	node.destination = destination;
+	node.expanded = false;
+	return index;
+}
+
+void ProofNumberSearch::FreeChildren(int node)
+{
+	int child = nodes[node].firstChild;
+	while(child >= 0)
+	{
+		const int next = nodes[child].nextSibling;
+		FreeChildren(child);
+		nodes[child].nextSibling = freeList;
+		freeList = child;
+		usedNodes--;
+		child = next;
+	}
+	nodes[node].firstChild = -1;
+}
+
+void ProofNumberSearch::CollectGarbage(int node, bool attacking)
+{
+	// nothing of the disproved node is printed, and all the children of the proved defender node are the proof
+	if(nodes[node].proof != 0)
+	{
+		FreeChildren(node);
+		return;
+	}
+	if(!attacking)
+		return;
+
+	// one mating move of the attacker is enough, the subtrees of the others are not needed anymore
+	int proving = nodes[node].firstChild;
+	while(nodes[proving].proof != 0)
+	{
+		proving = nodes[proving].nextSibling;
+	}
+	const int next = nodes[proving].nextSibling;
+	nodes[proving].nextSibling = -1;
+	int child = nodes[node].firstChild;
+	nodes[node].firstChild = proving;
+	while(child >= 0)
+	{
+		const int following = (child == proving ? next : nodes[child].nextSibling);
+		if(child != proving)
+		{
+			FreeChildren(child);
+			nodes[child].nextSibling = freeList;
+			freeList = child;
+			usedNodes--;
+		}
+		child = following;
+	}
+}
+
+bool ProofNumberSearch::Expand(int node, int ply, bool attacking)
+{
+	expanded++;
+	const Config::PlayerColour defender = Config::GetOppositePlayer(rootColour);
+
+	moves.Clear();
+	board.GetPossibleMoves(attacking ? rootColour : defender, moves);
+
+	int lastChild = -1;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		unsigned proof = 1;
+		unsigned disproof = 1;
+
+		MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
+		if(attacking)
+		{
+			// the attacker plays only the checks, and repeating them leads only back to the searched positions
+			const bool check = board.KingInCheck(defender) && !board.IsRepetition();
+			// after the last ply only the mate matters, so the evasions are counted only before it
+			const bool lastPly = (ply + 1 >= maxPlies);
+			bool evasion = false;
+			if(check)
+			{
+				replies.Clear();
+				if(lastPly)
+					evasion = board.HasLegalMove(defender);
+				else
+					board.GetPossibleMoves(defender, replies);
+			}
+			board.UndoMove(move);
+			if(!check)
+				continue;
+
+			// the defender with less evasions is easier to mate, without any it is mated and after the last ply it has escaped
+			if(!evasion && replies.Count() == 0)
+			{
+				proof = 0;
+				disproof = PROOF_INFINITY;
+			}
+			else if(lastPly)
+			{
+				proof = PROOF_INFINITY;
+				disproof = 0;
+			}
+			else
+			{
+				proof = (unsigned) replies.Count();
+			}
+		}
+		else
+		{
+			// the repeated position is a draw, so the attacker can't mate by it
+			const bool repetition = board.IsRepetition();
+			board.UndoMove(move);
+			if(repetition)
+			{
+				proof = PROOF_INFINITY;
+				disproof = 0;
+			}
+		}
+
+		const int child = AllocateNode(node, moves[i].piece.GetPositionCoord(), moves[i].destination.GetVectorCoord());
+		if(child < 0)
+		{
+			FreeChildren(node);
+			return false;
+		}
+		nodes[child].proof = proof;
+		nodes[child].disproof = disproof;
+		nodes[child].expanded = (proof == 0 || disproof == 0);
+
+		if(lastChild >= 0)
+			nodes[lastChild].nextSibling = child;
+		else
+			nodes[node].firstChild = child;
+		lastChild = child;
+	}
+
+	nodes[node].expanded = true;
+	return true;
+}
+
+void ProofNumberSearch::Update(int node, bool attacking)
+{
+	// the attacker needs one proved child and all of them disproved to fail, the defender the other way round
+	unsigned minimum = PROOF_INFINITY;
+	unsigned sum = 0;
+	for(int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+	{
+		minimum = Utils::Min(minimum, attacking ? nodes[child].proof : nodes[child].disproof);
+		sum = AddProof(sum, attacking ? nodes[child].disproof : nodes[child].proof);
+	}
+
+	nodes[node].proof = (attacking ? minimum : sum);
+	nodes[node].disproof = (attacking ? sum : minimum);
+}
+
+int ProofNumberSearch::GetProofDepth(int node) const
+{
+	int depth = 0;
+	for(int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+	{
+		depth = Utils::Max(depth, GetProofDepth(child) + 1);
+	}
+	return depth;
+}
+
+void ProofNumberSearch::PrintNode(FILE * output, int node, int ply) const
+{
+	char source[Notation::TILE_LENGTH + 1];
+	char destination[Notation::TILE_LENGTH + 1];
+	Notation::FormatTile(ChessVector(nodes[node].source), source);
+	Notation::FormatTile(ChessVector(nodes[node].destination), destination);
+
+	// the attacker's move to the defender without children is the mate
+	const bool mate = (ply & 1) == 0 && nodes[node].firstChild < 0;
+	fprintf(output, "%*s%s%s%s\n", ply * 2, "", source, destination, (mate ? "#" : ""));
+
+	for(int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+	{
+		PrintNode(output, child, ply + 1);
+	}
+}
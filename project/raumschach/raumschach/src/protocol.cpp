@@ -0,0 +1,372 @@
+#include "protocol.h"
+#include "constants.h"
+#include "notation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	const char * const ENGINE_NAME = "Raumschach";
+	const int MAX_HASH_SIZE = 4096;
+	const int MAX_THREAD_COUNT = 256;
+	const int MAX_LINE_LENGTH = 4096;
+
+	// the default transition table size in megabytes
+	const int DEFAULT_HASH_SIZE = Utils::Max(1, Config::TRANSITION_TABLE_SIZE / TransitionTable::GetSizeForMegabytes(1));
+
+	// returns the index of the token, or the token count if it isn't there
+	int FindToken(const std::vector<const char *>& tokens, const char * token, int start = 0)
+	{
+		for(int i = start; i < (int) tokens.size(); ++i)
+		{
+			if(strcmp(tokens[i], token) == 0)
+				return i;
+		}
+		return (int) tokens.size();
+	}
+
+	// writes the score as "cp <centipawns>" or "mate <moves>" (negative when the player on move is mated)
+	void FormatScore(int score, char * output, int length)
+	{
+		if(Utils::Abs(score) > Config::MATE_THRESHOLD)
+		{
+			const int mateMoves = (Config::MATE_SCORE - Utils::Abs(score) + 1) / 2;
+			snprintf(output, length, "mate %d", score > 0 ? mateMoves : - mateMoves);
+		}
+		else
+		{
+			snprintf(output, length, "cp %d", score * 100 / Const::PIECE_WORTH[Config::PAWN]);
+		}
+	}
+}
+
+ProtocolEngine::ProtocolEngine(ProtocolOutput * out)
+	:	output(out), movePool(), board(), colour(Config::WHITE), hashSize(DEFAULT_HASH_SIZE), threadCount(1), transitionTable(nullptr), stopFlag(false), infiniteSearch(false),
+		runningWorkers(0), reportedDepth(0)
+{
+	movePool.Initalize();
+	board = Board(DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), &movePool);
+	CreateSearchers();
+}
+
+ProtocolEngine::~ProtocolEngine()
+{
+	StopSearch();
+	DeleteSearchers();
+}
+
+bool ProtocolEngine::HandleCommand(const char * line)
+{
+	std::vector<char> buffer;
+	std::vector<const char *> tokens;
+	Notation::SplitCommand(line, buffer, tokens);
+	if(tokens.empty())
+		return true;
+
+	const char * command = tokens[0];
+	if(strcmp(command, "isready") == 0)
+	{
+		Write("readyok");
+		return true;
+	}
+
+	StopSearch();
+
+	if(strcmp(command, "quit") == 0)
+	{
+		return false;
+	}
+	else if(strcmp(command, "stop") == 0)
+	{
+		// the search is already stopped
+	}
+	else if(strcmp(command, "uci") == 0)
+	{
+		char response[MAX_LINE_LENGTH];
+		snprintf(response, sizeof(response), "id name %s", ENGINE_NAME);
+		Write(response);
+		snprintf(response, sizeof(response), "option name Hash type spin default %d min 1 max %d", DEFAULT_HASH_SIZE, MAX_HASH_SIZE);
+		Write(response);
+		snprintf(response, sizeof(response), "option name Threads type spin default 1 min 1 max %d", MAX_THREAD_COUNT);
+		Write(response);
+		Write("uciok");
+	}
+	else if(strcmp(command, "ucinewgame") == 0)
+	{
+		for(int i = 0; i < (int) searchers.size(); ++i)
+		{
+			searchers[i]->NewGame();
+		}
+	}
+	else if(strcmp(command, "setoption") == 0)
+	{
+		SetOption(tokens);
+	}
+	else if(strcmp(command, "position") == 0)
+	{
+		SetPosition(tokens);
+	}
+	else if(strcmp(command, "go") == 0)
+	{
+		StartSearch(tokens);
+	}
+	else
+	{
+		char response[MAX_LINE_LENGTH];
+		snprintf(response, sizeof(response), "info string unknown command %s", command);
+		Write(response);
+	}
+	return true;
+}
+
+void ProtocolEngine::WaitForSearch()
+{
+	// the infinite search never ends on its own
+	if(infiniteSearch)
+	{
+		SignalStop();
+	}
+	if(searchThread.joinable())
+	{
+		searchThread.join();
+	}
+}
+
+void ProtocolEngine::SetPosition(const std::vector<const char *>& tokens)
+{
+	CharString error;
+	if(!Notation::ParsePositionCommand(tokens, &movePool, board, colour, error))
+	{
+		Write(CharString("info string ") + error);
+	}
+}
+
+void ProtocolEngine::SetOption(const std::vector<const char *>& tokens)
+{
+	const int nameToken = FindToken(tokens, "name");
+	const int valueToken = FindToken(tokens, "value");
+	if(nameToken + 1 >= (int) tokens.size() || valueToken + 1 >= (int) tokens.size())
+	{
+		Write("info string setoption name <option> value <value>");
+		return;
+	}
+
+	const char * name = tokens[nameToken + 1];
+	const int value = atoi(tokens[valueToken + 1]);
+	if(strcmp(name, "Hash") == 0)
+	{
+		hashSize = Utils::Max(1, Utils::Min(value, MAX_HASH_SIZE));
+		CreateSearchers();
+	}
+	else if(strcmp(name, "Threads") == 0)
+	{
+		threadCount = Utils::Max(1, Utils::Min(value, MAX_THREAD_COUNT));
+		CreateSearchers();
+	}
+	else
+	{
+		char response[MAX_LINE_LENGTH];
+		snprintf(response, sizeof(response), "info string unknown option %s", name);
+		Write(response);
+	}
+}
+
+void ProtocolEngine::StartSearch(const std::vector<const char *>& tokens)
+{
+	const Notation::SearchLimits limits = Notation::ParseSearchCommand(tokens);
+
+	// the root moves are dealt to the workers in their order, so every worker gets moves of every kind
+	DynamicArray<Move> rootMoves(Const::MAX_PIECES_MOVES);
+	board.GetPossibleMoves(colour, rootMoves);
+	if(rootMoves.Count() == 0)
+	{
+		Write("bestmove 0000");
+		return;
+	}
+
+	const int workerCount = Utils::Min(threadCount, rootMoves.Count());
+	workerMoves.assign(workerCount, DynamicArray<Move>(rootMoves.Count() / workerCount + 1));
+	workerDepths.assign(workerCount, std::vector<SearchInfo>());
+	workerBest.assign(workerCount, Move());
+	if(workerCount > 1)
+	{
+		for(int i = 0; i < rootMoves.Count(); ++i)
+		{
+			workerMoves[i % workerCount] += rootMoves[i];
+		}
+	}
+
+	stopFlag = false;
+	infiniteSearch = limits.infinite;
+	reportedDepth = 0;
+	runningWorkers = workerCount;
+	searchStart = std::chrono::steady_clock::now();
+	searchThread = std::thread(&ProtocolEngine::RunSearch, this, limits.depth, limits.nodes, limits.moveTime, limits.infinite);
+}
+
+void ProtocolEngine::StopSearch()
+{
+	SignalStop();
+	WaitForSearch();
+}
+
+void ProtocolEngine::SignalStop()
+{
+	std::lock_guard<std::mutex> lock(searchMutex);
+	stopFlag = true;
+	workersFinished.notify_all();
+}
+
+void ProtocolEngine::CreateSearchers()
+{
+	DeleteSearchers();
+
+	// the Hash option is the memory of the whole engine, so all the threads search with a single table
+	transitionTable = new TransitionTable(TransitionTable::GetSizeForMegabytes(hashSize));
+	for(int i = 0; i < threadCount; ++i)
+	{
+		// the same seeds give the same searches for the same commands
+		RandomGenerator * rgen = new RandomGenerator(Config::DETERMINISTIC_SEED + i);
+		AIPlayer * searcher = new AIPlayer(Config::AI_PLAYER_SEARCH_DEPTH, 0, Config::WHITE, rgen);
+		DepthListener * listener = new DepthListener(this, i);
+		searcher->SetSharedTransitionTable(transitionTable);
+		searcher->SetStopFlag(&stopFlag);
+		searcher->SetSearchListener(listener);
+
+		generators.push_back(rgen);
+		searchers.push_back(searcher);
+		listeners.push_back(listener);
+	}
+}
+
+void ProtocolEngine::DeleteSearchers()
+{
+	for(int i = 0; i < (int) searchers.size(); ++i)
+	{
+		delete searchers[i];
+		delete listeners[i];
+		delete generators[i];
+	}
+	searchers.clear();
+	listeners.clear();
+	generators.clear();
+
+	delete transitionTable;
+	transitionTable = nullptr;
+}
+
+void ProtocolEngine::RunSearch(int depth, unsigned long long nodes, long long moveTime, bool infinite)
+{
+	const int workerCount = (int) workerMoves.size();
+	for(int i = 0; i < workerCount; ++i)
+	{
+		searchers[i]->SetNodeLimit(nodes ? Utils::Max(1ULL, nodes / workerCount) : 0ULL);
+	}
+
+	std::vector<std::thread> workers;
+	for(int i = 0; i < workerCount; ++i)
+	{
+		workers.push_back(std::thread(&ProtocolEngine::RunWorker, this, i, depth));
+	}
+
+	// the move time stops the workers, which end with the move of their last finished depth
+	if(moveTime > 0)
+	{
+		std::unique_lock<std::mutex> lock(searchMutex);
+		const bool finished = workersFinished.wait_until(lock, searchStart + std::chrono::milliseconds(moveTime),
+			[this]() { return runningWorkers == 0 || stopFlag; });
+		if(!finished)
+		{
+			stopFlag = true;
+		}
+	}
+	for(int i = 0; i < workerCount; ++i)
+	{
+		workers[i].join();
+	}
+
+	// the infinite search keeps its best move until it is stopped, even if it has finished all the depths
+	if(infinite)
+	{
+		std::unique_lock<std::mutex> lock(searchMutex);
+		workersFinished.wait(lock, [this]() { return stopFlag.load(); });
+	}
+
+	// the best move is the best one of the deepest depth finished by all the workers
+	Move bestMove = workerBest[0];
+	if(reportedDepth > 0)
+	{
+		int bestScore = - Config::SEARCH_INFINITY;
+		for(int i = 0; i < workerCount; ++i)
+		{
+			const SearchInfo& info = workerDepths[i][reportedDepth - 1];
+			if(info.score > bestScore && info.pv.Count())
+			{
+				bestScore = info.score;
+				bestMove = info.pv[0];
+			}
+		}
+	}
+
+	char move[Notation::MOVE_LENGTH + 1];
+	Notation::FormatMove(bestMove, move);
+	char response[MAX_LINE_LENGTH];
+	snprintf(response, sizeof(response), "bestmove %s", move);
+	Write(response);
+}
+
+void ProtocolEngine::RunWorker(int worker, int depth)
+{
+	workerBest[worker] = searchers[worker]->Search(board, colour, depth, workerMoves[worker]);
+
+	std::lock_guard<std::mutex> lock(searchMutex);
+	runningWorkers--;
+	workersFinished.notify_all();
+}
+
+void ProtocolEngine::DepthFinished(int worker, const SearchInfo& info)
+{
+	std::lock_guard<std::mutex> lock(searchMutex);
+	workerDepths[worker].push_back(info);
+
+	const int workerCount = (int) workerDepths.size();
+	for(;;)
+	{
+		int best = -1;
+		unsigned long long nodes = 0ULL;
+		for(int i = 0; i < workerCount; ++i)
+		{
+			if((int) workerDepths[i].size() <= reportedDepth)
+				return;
+
+			const SearchInfo& workerInfo = workerDepths[i][reportedDepth];
+			nodes += workerInfo.nodes;
+			if(best < 0 || workerInfo.score > workerDepths[best][reportedDepth].score)
+				best = i;
+		}
+
+		const SearchInfo& bestInfo = workerDepths[best][reportedDepth];
+		reportedDepth++;
+
+		const long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - searchStart).count();
+		char score[32];
+		FormatScore(bestInfo.score, score, sizeof(score));
+		char response[MAX_LINE_LENGTH];
+		int length = snprintf(response, sizeof(response), "info depth %d score %s nodes %llu nps %llu time %lld pv", reportedDepth, score, nodes,
+			nodes * 1000ULL / (unsigned long long) Utils::Max(milliseconds, 1LL), milliseconds);
+		for(int i = 0; i < bestInfo.pv.Count() && length + Notation::MOVE_LENGTH + 2 < (int) sizeof(response); ++i)
+		{
+			response[length++] = ' ';
+			Notation::FormatMove(bestInfo.pv[i], response + length);
+			length += Notation::MOVE_LENGTH;
+		}
+		Write(response);
+	}
+}
+
+void ProtocolEngine::Write(const char * line)
+{
+	std::lock_guard<std::mutex> lock(outputMutex);
+	output->WriteLine(line);
+}
@@ -8,7 +8,13 @@
 #include "random_generator.h"
 #include "graphicpanel.h"
 #include "player.h"
+#include "mctsplayer.h"
+#include "openingbook.h"
+#include "tablebase.h"
+#include "piecesquaretable.h"
+#include "nnue.h"
 #include <time.h>
+#include <thread>
 
 Raumschach::Raumschach()
 	:
@@ -19,12 +25,16 @@ Raumschach::Raumschach()
 	movePool(nullptr),
 	tileState(nullptr),
 	randGen(nullptr),
+	openingBook(nullptr),
+	tablebases(nullptr),
+	network(nullptr),
 	selectedPiece(),
 	selectedPieceMoves(),
 	currentPlayer(Config::WHITE),
 	gameEnded(false),
 	triedMove(false),
 	exitStatus(false),
+	deterministic(false),
 	moveStack()
 {}
 
@@ -48,10 +58,18 @@ Raumschach::~Raumschach()
 	render = nullptr;
 	delete randGen;
 	randGen = nullptr;
+	delete openingBook;
+	openingBook = nullptr;
+	delete tablebases;
+	tablebases = nullptr;
+	delete network;
+	network = nullptr;
 }
 
-void Raumschach::Initialize()
+void Raumschach::Initialize(bool deterministicMode)
 {
+	deterministic = deterministicMode;
+
 	render = new Render(SysConfig::SCREEN_WIDTH, SysConfig::SCREEN_HEIGHT);
 	if(! render)
 	{
@@ -74,7 +92,7 @@ void Raumschach::Initialize()
 	graphicPanel->Initialize();
 	InitButtons();
 
-	randGen = new RandomGenerator((unsigned int) time(NULL));
+	randGen = new RandomGenerator(deterministic ? Config::DETERMINISTIC_SEED : (unsigned int) time(NULL));
 	if(! randGen)
 	{
 		Error("ERROR: Failed to initialize the random generator").Post().Exit(SysConfig::EXIT_CHESS_INIT_ERROR);
@@ -85,7 +103,11 @@ void Raumschach::Initialize()
 	{
 		Error("ERROR: Failed to initialize move pool").Post().Exit(SysConfig::EXIT_CHESS_INIT_ERROR);
 	}
-	movePool->Initalize(randGen);
+	movePool->Initalize();
+
+	// the tuned piece square tables are optional, the default ones are used without them
+	// NOTE: they must be loaded before the board is created, as the board keeps its position worth
+	PieceSquareTable::Load(Config::PIECE_SQUARE_TABLE_FILENAME);
 
 	board = new Board( DynamicArray< Piece >(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), movePool);
 	if(! board)
@@ -95,6 +117,30 @@ void Raumschach::Initialize()
 
 	unsigned long long hash = board->GetHash();
 
+	// the opening book is optional, the ai players just search from the start without it
+	openingBook = new OpeningBook();
+	if(!openingBook->Open(Config::OPENING_BOOK_FILENAME))
+	{
+		delete openingBook;
+		openingBook = nullptr;
+	}
+
+	// the tablebases are optional as well
+	tablebases = new Tablebases();
+	if(!tablebases->Load(Config::TABLEBASE_DIRECTORY))
+	{
+		delete tablebases;
+		tablebases = nullptr;
+	}
+
+	// without a network file the ai players use the classical evaluation
+	network = new NnueNetwork();
+	if(!network->Load(Config::NNUE_FILENAME))
+	{
+		delete network;
+		network = nullptr;
+	}
+
 	tileState = new BoardTileState();
 	if(! tileState)
 	{
@@ -134,7 +180,7 @@ void Raumschach::IdleDraw()
 
 void Raumschach::MouseClick(SysConfig::MouseButton button, int x, int y)
 {
-	if(button == SysConfig::LEFT && graphicBoard->OnBoard(x, y) && !gameEnded && players[currentPlayer]->GetType() != Config::PLAYER_AI)
+	if(button == SysConfig::LEFT && graphicBoard->OnBoard(x, y) && !gameEnded && players[currentPlayer]->GetType() == Config::PLAYER_HUMAN)
 	{
 		ChessVector clickedPos = graphicBoard->ScreenToBoard(Rect(x, y));
 		Piece clickedPiece = board->GetPiece(clickedPos);
@@ -276,8 +322,28 @@ void Raumschach::MakePlayerMove()
 {
 	Piece movedPiece;
 	ChessVector destination;
+	bool hasMove = false;
+	if(!triedMove && players[currentPlayer]->GetType() == Config::PLAYER_AI)
+	{
+		// the ai player thinks in steps between the events, so the window doesn't freeze during the search
+		if(!static_cast<const AIPlayer *>(players[currentPlayer])->ThinkMove(movedPiece, destination, board, Config::AI_PLAYER_STEP_NODES))
+			return;
+		hasMove = true;
+	}
+	else if(!triedMove && players[currentPlayer]->GetType() == Config::PLAYER_MCTS)
+	{
+		// the monte carlo player plays its playouts in steps as well
+		if(!static_cast<const MCTSPlayer *>(players[currentPlayer])->ThinkMove(movedPiece, destination, board, Config::MCTS_STEP_PLAYOUTS))
+			return;
+		hasMove = true;
+	}
+	else if(!triedMove)
+	{
+		hasMove = players[currentPlayer]->GetMove(movedPiece, destination, board);
+	}
+
 	// if the player generates moves, make validation check and register it on the board
-	if(!triedMove && players[currentPlayer]->GetMove(movedPiece, destination, board))
+	if(hasMove)
 	{
 		if(board->ValidMove(movedPiece, destination))
 		{
@@ -384,7 +450,24 @@ void Raumschach::InitializeNewPlayer(Config::PlayerType type, Config::PlayerColo
 			int newIterations = previousIterations;
 			newDifficulty = Utils::Min(newDifficulty, Config::MAX_AI_PLAYER_SEARCH_DEPTH);
 			PostMessage("Initialized a new AI " + playerNames[colour] + " with difficulty of: " + CharString(newDifficulty) /*+ " and iterations of: " + CharString(newIterations)*/);
-			players[colour] = new AIPlayer(newDifficulty, newIterations, colour, randGen);
+			AIPlayer * aiPlayer = new AIPlayer(newDifficulty, newIterations, colour, randGen);
+			aiPlayer->SetOpeningBook(openingBook);
+			aiPlayer->SetTablebases(tablebases);
+			aiPlayer->SetNetwork(network);
+			if(deterministic)
+			{
+				aiPlayer->SetNodeLimit(Config::DETERMINISTIC_NODE_LIMIT);
+			}
+			players[colour] = aiPlayer;
+			triedMove = false;
+			break;
+		}
+	case Config::PLAYER_MCTS:
+		{
+			// the threads would make the deterministic games depend on the scheduling
+			const int threads = (deterministic ? 1 : Utils::Max(1, (int) std::thread::hardware_concurrency()));
+			PostMessage("Initialized a new MCTS " + playerNames[colour] + " with playouts of: " + CharString(Config::MCTS_PLAYOUTS));
+			players[colour] = new MCTSPlayer(Config::MCTS_PLAYOUTS, threads, colour, randGen->GetRand());
 			triedMove = false;
 			break;
 		}
@@ -409,4 +492,6 @@ void Raumschach::InitButtons()
 	graphicPanel->AddButton(new NewPlayerButton("Human Black", Colour(GraphicConfig::BUTTON_COLOUR), Rect(GraphicConfig::POSITION_BUTTON_NEW_HUMAN_BLACK), Config::PLAYER_HUMAN, Config::BLACK));
 	graphicPanel->AddButton(new NewPlayerButton("AI White", Colour(GraphicConfig::BUTTON_COLOUR), Rect(GraphicConfig::POSITION_BUTTON_NEW_AI_WHITE), Config::PLAYER_AI, Config::WHITE));
 	graphicPanel->AddButton(new NewPlayerButton("AI Black", Colour(GraphicConfig::BUTTON_COLOUR), Rect(GraphicConfig::POSITION_BUTTON_NEW_AI_BLACK), Config::PLAYER_AI, Config::BLACK));
+	graphicPanel->AddButton(new NewPlayerButton("MCTS White", Colour(GraphicConfig::BUTTON_COLOUR), Rect(GraphicConfig::POSITION_BUTTON_NEW_MCTS_WHITE), Config::PLAYER_MCTS, Config::WHITE));
+	graphicPanel->AddButton(new NewPlayerButton("MCTS Black", Colour(GraphicConfig::BUTTON_COLOUR), Rect(GraphicConfig::POSITION_BUTTON_NEW_MCTS_BLACK), Config::PLAYER_MCTS, Config::BLACK));
 }
\ No newline at end of file
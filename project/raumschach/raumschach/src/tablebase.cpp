@@ -0,0 +1,625 @@
+#include "tablebase.h"
+#include "board.h"
+#include "constants.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char TABLEBASE_PIECE_LETTERS[Config::PIECE_TYPE_COUNT] = { '?', 'K', 'Q', 'R', 'B', 'N', 'U', 'P' };
+
+static Config::PieceType GetPieceTypeFromLetter(char letter)
+{
+	for(int i = Config::KING; i < Config::PIECE_TYPE_COUNT; ++i)
+	{
+		if(TABLEBASE_PIECE_LETTERS[i] == letter)
+			return (Config::PieceType) i;
+	}
+	return Config::NO_TYPE;
+}
+
+// the symmetries of the cube (the axis permutations with the reflections of the axes), which keep the moves of the pawnless pieces
+static const int TABLEBASE_SYMMETRY_COUNT = 48;
+// the tiles of the white king folded by the symmetries: the lowest octant with x <= y <= z
+static const int TABLEBASE_KING_REGION_SIZE = 10;
+
+// The tables of the position index, set up before the main
+struct TablebaseIndexTables
+{
+	TablebaseIndexTables();
+
+	int transforms[TABLEBASE_SYMMETRY_COUNT][Config::BOARD_SIZE]; // the tile after the symmetry
+	int regionIndex[Config::BOARD_SIZE]; // the index of the tile in the king region, -1 if it is out of the region
+	int regionTiles[TABLEBASE_KING_REGION_SIZE];
+	int kingSymmetries[Config::BOARD_SIZE][TABLEBASE_SYMMETRY_COUNT]; // the symmetries moving the tile to the king region
+	int kingSymmetryCount[Config::BOARD_SIZE];
+	unsigned long long binomials[Config::BOARD_SIZE + 1][Config::TABLEBASE_MAX_PIECES + 1];
+};
+
+TablebaseIndexTables::TablebaseIndexTables()
+{
+	static const int PERMUTATIONS[6][3] = { {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0} };
+	for(int symmetry = 0; symmetry < TABLEBASE_SYMMETRY_COUNT; ++symmetry)
+	{
+		const int * permutation = PERMUTATIONS[symmetry / 8];
+		const int reflections = symmetry % 8;
+		for(int tile = 0; tile < Config::BOARD_SIZE; ++tile)
+		{
+			const ChessVector pos((coord) tile);
+			const int axes[3] = { pos.x, pos.y, pos.z };
+			int moved[3];
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				moved[axis] = axes[permutation[axis]];
+				if(reflections & (1 << axis))
+					moved[axis] = Config::BOARD_SIDE - 1 - moved[axis];
+			}
+			transforms[symmetry][tile] = ChessVector((coord) moved[0], (coord) moved[1], (coord) moved[2]).GetVectorCoord();
+		}
+	}
+
+	int regionSize = 0;
+	for(int tile = 0; tile < Config::BOARD_SIZE; ++tile)
+	{
+		const ChessVector pos((coord) tile);
+		const bool inRegion = pos.x <= pos.y && pos.y <= pos.z && pos.z <= Config::BOARD_SIDE / 2;
+		regionIndex[tile] = (inRegion ? regionSize : -1);
+		if(inRegion)
+			regionTiles[regionSize++] = tile;
+	}
+
+	for(int tile = 0; tile < Config::BOARD_SIZE; ++tile)
+	{
+		kingSymmetryCount[tile] = 0;
+		for(int symmetry = 0; symmetry < TABLEBASE_SYMMETRY_COUNT; ++symmetry)
+		{
+			if(regionIndex[transforms[symmetry][tile]] >= 0)
+				kingSymmetries[tile][kingSymmetryCount[tile]++] = symmetry;
+		}
+	}
+
+	for(int n = 0; n <= Config::BOARD_SIZE; ++n)
+	{
+		binomials[n][0] = 1ULL;
+		for(int k = 1; k <= Config::TABLEBASE_MAX_PIECES; ++k)
+		{
+			binomials[n][k] = (n > 0 ? binomials[n - 1][k - 1] + binomials[n - 1][k] : 0ULL);
+		}
+	}
+}
+
+static const TablebaseIndexTables INDEX_TABLES;
+
+/********** class TablebaseMaterial ***********/
+
+TablebaseMaterial::TablebaseMaterial()
+	: pieceCount(0)
+{
+	for(int i = 0; i < Config::TABLEBASE_MAX_PIECES; ++i)
+	{
+		types[i] = Config::NO_TYPE;
+		colours[i] = Config::WHITE;
+	}
+}
+
+bool TablebaseMaterial::FromSignature(const char * signature)
+{
+	pieceCount = 0;
+	int colour = Config::WHITE;
+	int kings[Config::PCOLOUR_COUNT] = {0};
+	for(const char * c = signature; *c; ++c)
+	{
+		if(*c == 'v')
+		{
+			if(colour == Config::BLACK)
+				return false;
+			colour = Config::BLACK;
+			continue;
+		}
+
+		Config::PieceType type = GetPieceTypeFromLetter(*c);
+		if(type == Config::NO_TYPE || type == Config::PAWN || pieceCount >= Config::TABLEBASE_MAX_PIECES)
+			return false;
+
+		if(type == Config::KING)
+			kings[colour]++;
+
+		types[pieceCount] = (unsigned char) type;
+		colours[pieceCount] = (unsigned char) colour;
+		++pieceCount;
+	}
+
+	if(kings[Config::WHITE] != 1 || kings[Config::BLACK] != 1)
+		return false;
+
+	Canonicalize();
+	return true;
+}
+
+bool TablebaseMaterial::FromBoard(const Board& board, bool& swapColours)
+{
+	pieceCount = 0;
+	swapColours = false;
+	if(board.GetPieceCount() > Config::TABLEBASE_MAX_PIECES)
+		return false;
+
+	int kings = 0;
+	for(int col = 0; col < Config::PCOLOUR_COUNT; ++col)
+	{
+		const DynamicArray<Piece>& pieces = board.GetPieces((Config::PlayerColour) col);
+		for(int i = 0; i < pieces.Count(); ++i)
+		{
+			const Config::PieceType type = pieces[i].GetType();
+			if(type == Config::PAWN)
+				return false;
+			if(type == Config::KING)
+				++kings;
+			types[pieceCount] = (unsigned char) type;
+			colours[pieceCount] = (unsigned char) col;
+			++pieceCount;
+		}
+	}
+
+	if(kings != Config::PCOLOUR_COUNT)
+		return false;
+
+	swapColours = Canonicalize();
+	return true;
+}
+
+bool TablebaseMaterial::Canonicalize()
+{
+	// take the non king pieces of every player sorted by type (the stronger pieces have smaller types)
+	unsigned char playerTypes[Config::PCOLOUR_COUNT][Config::TABLEBASE_MAX_PIECES];
+	int playerCount[Config::PCOLOUR_COUNT] = {0};
+	for(int i = 0; i < pieceCount; ++i)
+	{
+		if(types[i] != Config::KING)
+		{
+			playerTypes[colours[i]][playerCount[colours[i]]++] = types[i];
+		}
+	}
+
+	for(int col = 0; col < Config::PCOLOUR_COUNT; ++col)
+	{
+		for(int i = 1; i < playerCount[col]; ++i)
+		{
+			unsigned char x = playerTypes[col][i];
+			int j = i;
+			while(j > 0 && x < playerTypes[col][j - 1])
+			{
+				playerTypes[col][j] = playerTypes[col][j - 1];
+				--j;
+			}
+			playerTypes[col][j] = x;
+		}
+	}
+
+	// the white player must be the stronger one - with more pieces, or with stronger pieces
+	bool swap = playerCount[Config::BLACK] > playerCount[Config::WHITE];
+	if(playerCount[Config::BLACK] == playerCount[Config::WHITE])
+	{
+		for(int i = 0; i < playerCount[Config::WHITE]; ++i)
+		{
+			if(playerTypes[Config::WHITE][i] != playerTypes[Config::BLACK][i])
+			{
+				swap = playerTypes[Config::BLACK][i] < playerTypes[Config::WHITE][i];
+				break;
+			}
+		}
+	}
+
+	const int stronger = (swap ? Config::BLACK : Config::WHITE);
+	const int weaker = (swap ? Config::WHITE : Config::BLACK);
+
+	int slot = 0;
+	types[slot] = Config::KING;
+	colours[slot++] = Config::WHITE;
+	types[slot] = Config::KING;
+	colours[slot++] = Config::BLACK;
+	for(int i = 0; i < playerCount[stronger]; ++i)
+	{
+		types[slot] = playerTypes[stronger][i];
+		colours[slot++] = Config::WHITE;
+	}
+	for(int i = 0; i < playerCount[weaker]; ++i)
+	{
+		types[slot] = playerTypes[weaker][i];
+		colours[slot++] = Config::BLACK;
+	}
+
+	return swap;
+}
+
+void TablebaseMaterial::GetSignature(char * dest) const
+{
+	int length = 0;
+	for(int col = 0; col < Config::PCOLOUR_COUNT; ++col)
+	{
+		if(col == Config::BLACK)
+			dest[length++] = 'v';
+		for(int i = 0; i < pieceCount; ++i)
+		{
+			if(colours[i] == col)
+				dest[length++] = TABLEBASE_PIECE_LETTERS[types[i]];
+		}
+	}
+	dest[length] = '\0';
+}
+
+unsigned TablebaseMaterial::GetKey() const
+{
+	unsigned key = (unsigned) pieceCount;
+	for(int i = 0; i < pieceCount; ++i)
+	{
+		key = (key << 4) | types[i] | (colours[i] << 3);
+	}
+	return key;
+}
+
+int TablebaseMaterial::GetPieceCount() const
+{
+	return pieceCount;
+}
+
+Config::PieceType TablebaseMaterial::GetType(int slot) const
+{
+	return (Config::PieceType) types[slot];
+}
+
+Config::PlayerColour TablebaseMaterial::GetColour(int slot) const
+{
+	return (Config::PlayerColour) colours[slot];
+}
+
+unsigned long long TablebaseMaterial::GetEntryCount() const
+{
+	unsigned long long count = (unsigned long long) Config::PCOLOUR_COUNT * TABLEBASE_KING_REGION_SIZE * Config::BOARD_SIZE;
+	for(int first = 2; first < pieceCount; first = GetGroupEnd(first))
+	{
+		count *= INDEX_TABLES.binomials[Config::BOARD_SIZE][GetGroupEnd(first) - first];
+	}
+	return count;
+}
+
+bool TablebaseMaterial::IsDrawnByMaterial() const
+{
+	int others[Config::PCOLOUR_COUNT] = {0};
+	for(int i = 0; i < pieceCount; ++i)
+	{
+		if(types[i] == Config::QUEEN || types[i] == Config::PAWN)
+			return false;
+		if(types[i] != Config::KING)
+			others[colours[i]]++;
+	}
+	return others[Config::WHITE] <= 2 && others[Config::BLACK] <= 2;
+}
+
+TablebaseMaterial TablebaseMaterial::RemovePiece(int slot) const
+{
+	TablebaseMaterial result(*this);
+	if(slot >= 0 && slot < pieceCount && types[slot] != Config::KING)
+	{
+		for(int i = slot + 1; i < pieceCount; ++i)
+		{
+			result.types[i - 1] = types[i];
+			result.colours[i - 1] = colours[i];
+		}
+		result.pieceCount--;
+		result.Canonicalize();
+	}
+	return result;
+}
+
+unsigned long long TablebaseMaterial::GetIndex(const Board& board, Config::PlayerColour colourToMove, bool swapColours) const
+{
+	// the pieces of the board are matched to the slots by colour and type
+	int squares[Config::TABLEBASE_MAX_PIECES];
+	bool filled[Config::TABLEBASE_MAX_PIECES] = {false};
+	for(int col = 0; col < Config::PCOLOUR_COUNT; ++col)
+	{
+		const DynamicArray<Piece>& pieces = board.GetPieces((Config::PlayerColour) col);
+		const unsigned char slotColour = (unsigned char) (swapColours ? Config::GetOppositePlayer((Config::PlayerColour) col) : col);
+		for(int i = 0; i < pieces.Count(); ++i)
+		{
+			for(int slot = 0; slot < pieceCount; ++slot)
+			{
+				if(types[slot] == pieces[i].GetType() && colours[slot] == slotColour && !filled[slot])
+				{
+					squares[slot] = pieces[i].GetPositionCoord();
+					filled[slot] = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// the position is indexed after the symmetry, which gives the smallest index with the white king in its region
+	const unsigned long long colourIndex = (unsigned long long) (swapColours ? Config::GetOppositePlayer(colourToMove) : colourToMove);
+	const int king = squares[0];
+	unsigned long long index = GetSymmetricIndex(squares, colourIndex, INDEX_TABLES.kingSymmetries[king][0]);
+	for(int i = 1; i < INDEX_TABLES.kingSymmetryCount[king]; ++i)
+	{
+		index = Utils::Min(index, GetSymmetricIndex(squares, colourIndex, INDEX_TABLES.kingSymmetries[king][i]));
+	}
+	return index;
+}
+
+bool TablebaseMaterial::SetupBoard(unsigned long long index, Board& board, Config::PlayerColour& colourToMove) const
+{
+	int groups[Config::TABLEBASE_MAX_PIECES];
+	int groupCount = 0;
+	for(int first = 2; first < pieceCount; first = GetGroupEnd(first))
+	{
+		groups[groupCount++] = first;
+	}
+
+	int squares[Config::TABLEBASE_MAX_PIECES];
+	for(int group = groupCount - 1; group >= 0; --group)
+	{
+		const int first = groups[group];
+		const int count = GetGroupEnd(first) - first;
+		const unsigned long long groupSize = INDEX_TABLES.binomials[Config::BOARD_SIZE][count];
+		unsigned long long combination = index % groupSize;
+		index /= groupSize;
+
+		// the biggest tile is the one with the biggest binomial not exceeding the combination, the smaller ones follow
+		int tile = Config::BOARD_SIZE;
+		for(int i = count - 1; i >= 0; --i)
+		{
+			do
+			{
+				--tile;
+			}
+			while(INDEX_TABLES.binomials[tile][i + 1] > combination);
+			squares[first + i] = tile;
+			combination -= INDEX_TABLES.binomials[tile][i + 1];
+		}
+	}
+	squares[1] = (int) (index % Config::BOARD_SIZE);
+	index /= Config::BOARD_SIZE;
+	squares[0] = INDEX_TABLES.regionTiles[index % TABLEBASE_KING_REGION_SIZE];
+	index /= TABLEBASE_KING_REGION_SIZE;
+	colourToMove = (Config::PlayerColour) index;
+
+	for(int i = 0; i < pieceCount; ++i)
+	{
+		for(int j = i + 1; j < pieceCount; ++j)
+		{
+			if(squares[i] == squares[j])
+				return false;
+		}
+	}
+
+	board.Clear();
+	for(int slot = 0; slot < pieceCount; ++slot)
+	{
+		board.AddPiece(Piece((Config::PieceType) types[slot], (Config::PlayerColour) colours[slot], (coord) squares[slot]));
+	}
+	return true;
+}
+
+int TablebaseMaterial::GetGroupEnd(int first) const
+{
+	int end = first + 1;
+	while(end < pieceCount && types[end] == types[first] && colours[end] == colours[first])
+	{
+		++end;
+	}
+	return end;
+}
+
+unsigned long long TablebaseMaterial::GetSymmetricIndex(const int squares[], unsigned long long colourIndex, int symmetry) const
+{
+	const int * transform = INDEX_TABLES.transforms[symmetry];
+	unsigned long long index = colourIndex * TABLEBASE_KING_REGION_SIZE + (unsigned long long) INDEX_TABLES.regionIndex[transform[squares[0]]];
+	index = index * Config::BOARD_SIZE + (unsigned long long) transform[squares[1]];
+
+	for(int first = 2; first < pieceCount; )
+	{
+		const int end = GetGroupEnd(first);
+		const int count = end - first;
+
+		// the tiles of the pieces of the same type are sorted and indexed as a combination (in the combinatorial number system)
+		int tiles[Config::TABLEBASE_MAX_PIECES];
+		for(int i = 0; i < count; ++i)
+		{
+			const int tile = transform[squares[first + i]];
+			int j = i;
+			while(j > 0 && tile < tiles[j - 1])
+			{
+				tiles[j] = tiles[j - 1];
+				--j;
+			}
+			tiles[j] = tile;
+		}
+
+		unsigned long long combination = 0ULL;
+		for(int i = 0; i < count; ++i)
+		{
+			combination += INDEX_TABLES.binomials[tiles[i]][i + 1];
+		}
+		index = index * INDEX_TABLES.binomials[Config::BOARD_SIZE][count] + combination;
+		first = end;
+	}
+	return index;
+}
+
+/************ class Tablebase *************/
+
+Tablebase::Tablebase()
+	:
+	values(nullptr),
+	entryCount(0ULL)
+{}
+
+bool Tablebase::Open(const char * filename)
+{
+	if(!file.Open(filename))
+		return false;
+
+	const TablebaseHeader * header = (const TablebaseHeader *) file.GetData();
+	char signature[Config::TABLEBASE_MAX_SIGNATURE] = "";
+	bool valid = file.GetSize() >= sizeof(TablebaseHeader)
+		&& memcmp(header->magic, Config::TABLEBASE_MAGIC, sizeof(header->magic)) == 0;
+
+	if(valid)
+	{
+		memcpy(signature, header->signature, sizeof(signature) - 1);
+		signature[sizeof(signature) - 1] = '\0';
+		valid = material.FromSignature(signature)
+			&& header->entryCount == material.GetEntryCount()
+			&& file.GetSize() >= sizeof(TablebaseHeader) + header->entryCount;
+	}
+
+	if(!valid)
+	{
+		file.Close();
+		return false;
+	}
+
+	values = file.GetData() + sizeof(TablebaseHeader);
+	entryCount = header->entryCount;
+	return true;
+}
+
+const TablebaseMaterial& Tablebase::GetMaterial() const
+{
+	return material;
+}
+
+/************ class Tablebases ************/
+
+Tablebases::Tablebases()
+	: maxPieces(0)
+{}
+
+Tablebases::~Tablebases()
+{
+	for(auto it = tables.begin(); it != tables.end(); ++it)
+	{
+		delete it->second;
+	}
+	tables.clear();
+}
+
+int Tablebases::Load(const char * directory)
+{
+	// try every combination of up to two non king pieces
+	const int firstType = Config::QUEEN;
+	const int lastType = Config::UNICORN;
+	int loaded = 0;
+	char filename[SysConfig::MAX_PATH];
+	for(int white0 = Config::NO_TYPE; white0 <= lastType; ++white0)
+	{
+		for(int white1 = Config::NO_TYPE; white1 <= lastType; ++white1)
+		{
+			for(int black0 = Config::NO_TYPE; black0 <= lastType; ++black0)
+			{
+				const int extra[3] = { white0, white1, black0 };
+				char signature[Config::TABLEBASE_MAX_SIGNATURE] = "K";
+				int length = 1;
+				int count = 2;
+				bool valid = true;
+				for(int i = 0; i < (int) (COUNT_OF(extra)); ++i)
+				{
+					if(i == 2)
+					{
+						signature[length++] = 'v';
+						signature[length++] = 'K';
+					}
+					if(extra[i] == Config::NO_TYPE)
+						continue;
+					valid &= extra[i] >= firstType;
+					signature[length++] = TABLEBASE_PIECE_LETTERS[extra[i]];
+					++count;
+				}
+				signature[length] = '\0';
+
+				TablebaseMaterial material;
+				if(!valid || count > Config::TABLEBASE_MAX_PIECES || !material.FromSignature(signature) || tables.count(material.GetKey()))
+					continue;
+
+				GetFilename(material, directory, filename, sizeof(filename));
+				loaded += (AddTable(filename) ? 1 : 0);
+			}
+		}
+	}
+	return loaded;
+}
+
+bool Tablebases::AddTable(const char * filename)
+{
+	Tablebase * table = new Tablebase();
+	if(!table->Open(filename) || tables.count(table->GetMaterial().GetKey()))
+	{
+		delete table;
+		return false;
+	}
+	tables[table->GetMaterial().GetKey()] = table;
+	maxPieces = Utils::Max(maxPieces, table->GetMaterial().GetPieceCount());
+	return true;
+}
+
+int Tablebases::GetTableCount() const
+{
+	return (int) tables.size();
+}
+
+bool Tablebases::HasTable(const TablebaseMaterial& material) const
+{
+	return tables.count(material.GetKey()) != 0;
+}
+
+int Tablebases::GetMaxPieces() const
+{
+	return maxPieces;
+}
+
+bool Tablebases::ProbeValue(const Board& board, Config::PlayerColour colourToMove, unsigned char& value) const
+{
+	TablebaseMaterial material;
+	bool swapColours = false;
+	if(!material.FromBoard(board, swapColours))
+		return false;
+
+	if(material.IsDrawnByMaterial())
+	{
+		value = Config::TABLEBASE_DRAW;
+		return true;
+	}
+
+	auto found = tables.find(material.GetKey());
+	if(found == tables.end())
+		return false;
+
+	value = found->second->GetValue(material.GetIndex(board, colourToMove, swapColours));
+	return value != Config::TABLEBASE_INVALID;
+}
+
+bool Tablebases::Probe(const Board& board, Config::PlayerColour colourToMove, int& score) const
+{
+	unsigned char value = Config::TABLEBASE_DRAW;
+	if(!ProbeValue(board, colourToMove, value))
+		return false;
+
+	score = 0;
+	if(IsWin(value))
+	{
+		score = Config::TABLEBASE_WIN_SCORE - GetDistanceToMate(value);
+	}
+	else if(IsLoss(value))
+	{
+		score = - Config::TABLEBASE_WIN_SCORE + GetDistanceToMate(value);
+	}
+	return true;
+}
+
+void Tablebases::GetFilename(const TablebaseMaterial& material, const char * directory, char * dest, int destSize)
+{
+	char signature[Config::TABLEBASE_MAX_SIGNATURE] = "";
+	material.GetSignature(signature);
+	dest[0] = '\0';
+	strncat(dest, directory, destSize - 1);
+	strncat(dest, "/", destSize - 1 - strlen(dest));
+	strncat(dest, signature, destSize - 1 - strlen(dest));
+	strncat(dest, Config::TABLEBASE_EXTENSION, destSize - 1 - strlen(dest));
+}
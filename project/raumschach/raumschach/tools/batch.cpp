@@ -0,0 +1,269 @@
+// Batch analysis of the positions of a text file
+// Usage: batch [-depth depth] [-nodes count] [-threads count] [-queue size] input_file [output_file]
+// Every line of the input is a position in the Notation ("w KAc1 ..."), optionally preceded by its id. The lines without an id
+// get their line number. The positions are read into a bounded queue, so the memory doesn't grow with the input, and searched by
+// the worker threads, each with its own ai player and all of them sharing the move pool. Every result is written as soon as it is
+// finished (so not in the input order) as a line "id move score depth nodes", or "id invalid" for the positions that can't be read.
+// Every position is searched with empty tables, so its result doesn't depend on the thread count or the other positions.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "notation.h"
+#include "charstring.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+struct BatchJob
+{
+	CharString id;
+	CharString position;
+};
+
+// Fixed capacity queue between the reader and the workers, the reader waits while it is full
+class BatchQueue
+{
+public:
+	BatchQueue(int capacity) : capacity(capacity), closed(false) {}
+
+	void Push(const BatchJob& job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this]() { return (int) jobs.size() < capacity; });
+		jobs.push_back(job);
+		notEmpty.notify_one();
+	}
+
+	// Waits for the next job, returns false when the queue is closed and there are no more jobs
+	bool Pop(BatchJob& job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this]() { return !jobs.empty() || closed; });
+		if(jobs.empty())
+			return false;
+
+		job = jobs.front();
+		jobs.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+
+	// No more jobs will be pushed, the workers end after the remaining ones
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+	}
+
+private:
+	// disable copy and assignment
+	BatchQueue(const BatchQueue& copy);
+	BatchQueue& operator=(const BatchQueue& assign);
+
+	const int capacity;
+	bool closed;
+	std::deque<BatchJob> jobs;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+};
+
+struct BatchSettings
+{
+	int depth;
+	unsigned long long nodes;
+};
+
+// the shared output of the workers
+struct BatchOutput
+{
+	FILE * file;
+	std::mutex lock;
+	int positions;
+	unsigned long long nodes;
+};
+
+static void AnalysePositions(const BatchSettings& settings, BitBoardMovePool * movePool, BatchQueue& queue, BatchOutput& output)
+{
+	RandomGenerator rgen(Config::DETERMINISTIC_SEED);
+	AIPlayer searcher(settings.depth, 0, Config::WHITE, &rgen);
+	searcher.SetNodeLimit(settings.nodes);
+
+	BatchJob job;
+	while(queue.Pop(job))
+	{
+		char result[128];
+		unsigned long long nodes = 0ULL;
+		DynamicArray<Piece> pieces;
+		Config::PlayerColour colour = Config::WHITE;
+		if(!Notation::ParsePosition(job.position.GetPtr(), pieces, colour))
+		{
+			snprintf(result, sizeof(result), "invalid");
+		}
+		else
+		{
+			Board board(pieces, movePool);
+			searcher.NewGame();
+			const Move best = searcher.Search(board, colour);
+			const SearchStats& stats = searcher.GetSearchStats();
+			nodes = stats.nodes;
+
+			// without a move the player is mated or it is a stalemate
+			char move[Notation::MOVE_LENGTH + 1] = "0000";
+			int score = (board.KingInCheck(colour) ? - Config::MATE_SCORE : 0);
+			if(best.piece.GetType() != Config::NO_TYPE)
+			{
+				Notation::FormatMove(best, move);
+				score = best.heuristic;
+			}
+			snprintf(result, sizeof(result), "%s %d %d %llu", move, score, stats.depth, nodes);
+		}
+
+		std::lock_guard<std::mutex> lock(output.lock);
+		fprintf(output.file, "%s %s\n", job.id.GetPtr(), result);
+		fflush(output.file);
+		output.positions++;
+		output.nodes += nodes;
+	}
+}
+
+// splits the input line to the id and the position, the position starts with the player on move
+static bool ReadJob(char * line, int lineNumber, BatchJob& job)
+{
+	line[strcspn(line, "\r\n")] = '\0';
+	while(isspace((unsigned char) *line))
+		++line;
+	if(*line == '\0' || *line == '#')
+		return false;
+
+	const bool hasId = !((line[0] == 'w' || line[0] == 'b') && isspace((unsigned char) line[1]));
+	if(!hasId)
+	{
+		job.id = CharString(lineNumber);
+		job.position = CharString(line);
+		return true;
+	}
+
+	char * position = line + strcspn(line, " \t");
+	if(*position)
+	{
+		*position = '\0';
+		++position;
+	}
+	job.id = CharString(line);
+	job.position = CharString(position);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	BatchSettings settings;
+	settings.depth = Config::AI_PLAYER_SEARCH_DEPTH;
+	settings.nodes = 0ULL;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	int queueSize = 0;
+	bool depthSet = false;
+	const char * inputName = nullptr;
+	const char * outputName = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-depth") == 0 && i + 1 < argc)
+		{
+			settings.depth = atoi(argv[++i]);
+			depthSet = true;
+		}
+		else if(strcmp(argv[i], "-nodes") == 0 && i + 1 < argc)
+			settings.nodes = strtoull(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-queue") == 0 && i + 1 < argc)
+			queueSize = atoi(argv[++i]);
+		else if(!inputName)
+			inputName = argv[i];
+		else
+			outputName = argv[i];
+	}
+
+	if(!inputName)
+	{
+		printf("Usage: batch [-depth depth] [-nodes count] [-threads count] [-queue size] input_file [output_file]\n");
+		return 1;
+	}
+
+	// the node budget deepens the search up to the depth, so without an explicit depth it is the deepest one
+	if(settings.nodes && !depthSet)
+	{
+		settings.depth = Config::MAX_AI_PLAYER_SEARCH_DEPTH;
+	}
+	settings.depth = Utils::Max(1, settings.depth);
+	threadCount = Utils::Max(1, threadCount);
+	// a few jobs per worker keep them busy while the reader waits
+	queueSize = (queueSize > 0 ? queueSize : threadCount * 4);
+
+	FILE * input = fopen(inputName, "r");
+	if(!input)
+	{
+		printf("Could not open the input file %s\n", inputName);
+		return 1;
+	}
+
+	BatchOutput output;
+	output.file = (outputName ? fopen(outputName, "w") : stdout);
+	output.positions = 0;
+	output.nodes = 0ULL;
+	if(!output.file)
+	{
+		printf("Could not open the output file %s\n", outputName);
+		fclose(input);
+		return 1;
+	}
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BatchQueue queue(queueSize);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads.push_back(std::thread(AnalysePositions, std::cref(settings), &movePool, std::ref(queue), std::ref(output)));
+	}
+
+	char line[4096];
+	BatchJob job;
+	for(int lineNumber = 1; fgets(line, sizeof(line), input); ++lineNumber)
+	{
+		if(ReadJob(line, lineNumber, job))
+		{
+			queue.Push(job);
+		}
+	}
+	queue.Close();
+	fclose(input);
+
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads[t].join();
+	}
+	const long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	if(outputName)
+	{
+		fclose(output.file);
+	}
+	fprintf(stderr, "Analysed %d positions in %lld ms (%.1f positions/second, %llu nodes)\n", output.positions, milliseconds,
+		(float) output.positions * 1000.0f / (float) Utils::Max(milliseconds, 1LL), output.nodes);
+	return 0;
+}
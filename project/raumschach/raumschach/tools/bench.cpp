@@ -0,0 +1,14 @@
+// Runs the regression benchmark without the graphical dependencies
+// Usage: bench [depth]
+// The printed node count is the search signature, it must stay the same for the patches that don't change the search
+
+#include "configuration.h"
+#include "bench.h"
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+	const int depth = (argc > 1 ? atoi(argv[1]) : Config::BENCH_DEPTH);
+	Bench::Run(depth > 0 ? depth : Config::BENCH_DEPTH);
+	return 0;
+}
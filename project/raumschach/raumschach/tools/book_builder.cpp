@@ -0,0 +1,200 @@
+// Offline generator of the opening book
+// Usage: book_builder [output file] [plies] [search depth] [threads]
+// Every position of the book tree (starting from Const::INITIAL_PIECES) has all its moves scored by a full search,
+// the best ones are written to the book and their positions are expanded in the next ply.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "openingbook.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+
+struct BookPosition
+{
+	Board board;
+	Config::PlayerColour colour;
+};
+
+// a single move of a book position, that has to be scored
+struct BookJob
+{
+	int position;
+	Move move;
+	int score;
+};
+
+static bool JobCompare(const BookJob& lhs, const BookJob& rhs)
+{
+	if(lhs.position != rhs.position)
+		return lhs.position < rhs.position;
+	return lhs.score > rhs.score;
+}
+
+static bool EntryCompare(const BookEntry& lhs, const BookEntry& rhs)
+{
+	if(lhs.hash != rhs.hash)
+		return lhs.hash < rhs.hash;
+	return lhs.weight > rhs.weight;
+}
+
+// scores the jobs from the shared job counter until there are no more
+static void ScoreJobs(const std::vector<BookPosition>& positions, std::vector<BookJob>& jobs, std::atomic<int>& nextJob, int depth, unsigned seed)
+{
+	RandomGenerator rgen(seed);
+	AIPlayer searcher(depth, 0, Config::WHITE, &rgen);
+	for(int i = nextJob++; i < (int) jobs.size(); i = nextJob++)
+	{
+		BookJob& job = jobs[i];
+		const Config::PlayerColour colour = positions[job.position].colour;
+		const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+
+		Board board(positions[job.position].board);
+		board.MovePiece(job.move.piece, job.move.destination, job.move.pieceMoves, true);
+
+		Config::KingState state = board.KingCheckState(oppositeColour);
+		if(state == Config::CHECKMATE)
+		{
+			// the same score as the search gives for the reply side mated at its root, so it stays above the longer mates
+			job.score = Config::MATE_SCORE;
+		}
+		else if(state == Config::STALEMATE)
+		{
+			job.score = 0;
+		}
+		else
+		{
+			// every job starts with empty tables, so its score doesn't depend on the jobs the thread searched before
+			searcher.NewGame();
+			// the reply is evaluated for the opposite player
+			job.score = - searcher.Search(board, oppositeColour).heuristic;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char * filename = (argc > 1 ? argv[1] : Config::OPENING_BOOK_FILENAME);
+	const int plies = (argc > 2 ? atoi(argv[2]) : Config::OPENING_BOOK_MAX_PLIES);
+	int depth = (argc > 3 ? atoi(argv[3]) : Config::AI_PLAYER_SEARCH_DEPTH);
+	int threadCount = (argc > 4 ? atoi(argv[4]) : (int) std::thread::hardware_concurrency());
+
+	depth = Utils::Max(1, depth);
+	threadCount = Utils::Max(1, threadCount);
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	std::vector<BookPosition> positions(1);
+	positions[0].board = Board(DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), &movePool);
+	positions[0].colour = Config::WHITE;
+
+	std::unordered_set<unsigned long long> visited;
+	visited.insert(positions[0].board.GetPositionHash(Config::WHITE));
+
+	std::vector<BookEntry> entries;
+
+	for(int ply = 0; ply < plies && !positions.empty(); ++ply)
+	{
+		// create a job for every move of every position in the current ply
+		std::vector<BookJob> jobs;
+		DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+		for(int p = 0; p < (int) positions.size(); ++p)
+		{
+			moves.Clear();
+			positions[p].board.GetPossibleMoves(positions[p].colour, moves);
+			for(int m = 0; m < moves.Count(); ++m)
+			{
+				BookJob job;
+				job.position = p;
+				job.move = moves[m];
+				job.score = 0;
+				jobs.push_back(job);
+			}
+		}
+
+		printf("Ply %d: %d positions, %d moves to search\n", ply + 1, (int) positions.size(), (int) jobs.size());
+
+		std::atomic<int> nextJob(0);
+		std::vector<std::thread> workers;
+		for(int t = 0; t < threadCount; ++t)
+		{
+			workers.push_back(std::thread(ScoreJobs, std::cref(positions), std::ref(jobs), std::ref(nextJob), depth, 123u + t));
+		}
+		for(int t = 0; t < threadCount; ++t)
+		{
+			workers[t].join();
+		}
+
+		// keep the best moves of every position and expand them for the next ply
+		std::sort(jobs.begin(), jobs.end(), JobCompare);
+		std::vector<BookPosition> nextPositions;
+		for(int first = 0; first < (int) jobs.size(); )
+		{
+			const int position = jobs[first].position;
+			const int bestScore = jobs[first].score;
+			int kept = 0;
+			int current = first;
+			for(; current < (int) jobs.size() && jobs[current].position == position; ++current)
+			{
+				const int scoreLoss = bestScore - jobs[current].score;
+				if(kept >= Config::OPENING_BOOK_MOVES_PER_POSITION || scoreLoss >= Const::BEST_MOVE_THRESHOLD)
+					continue;
+
+				const BookPosition& source = positions[position];
+				BookEntry entry;
+				memset(&entry, 0, sizeof(entry));
+				entry.hash = source.board.GetPositionHash(source.colour);
+				entry.source = (unsigned char) jobs[current].move.piece.GetPositionCoord();
+				entry.destination = (unsigned char) jobs[current].move.destination.GetVectorCoord();
+				entry.weight = (unsigned short) (Const::BEST_MOVE_THRESHOLD - scoreLoss);
+				entry.score = jobs[current].score;
+				entries.push_back(entry);
+				++kept;
+
+				BookPosition next;
+				next.board = source.board;
+				next.board.MovePiece(jobs[current].move.piece, jobs[current].move.destination, jobs[current].move.pieceMoves, true);
+				next.colour = Config::GetOppositePlayer(source.colour);
+				if(visited.insert(next.board.GetPositionHash(next.colour)).second)
+				{
+					nextPositions.push_back(next);
+				}
+			}
+			first = current;
+		}
+		positions.swap(nextPositions);
+	}
+
+	std::sort(entries.begin(), entries.end(), EntryCompare);
+
+	FILE * output = fopen(filename, "wb");
+	if(!output)
+	{
+		printf("Could not open %s for writing\n", filename);
+		return 1;
+	}
+
+	BookHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, Config::OPENING_BOOK_MAGIC, sizeof(header.magic));
+	header.entryCount = (unsigned int) entries.size();
+	header.plies = (unsigned int) plies;
+	fwrite(&header, sizeof(header), 1, output);
+	if(!entries.empty())
+	{
+		fwrite(&entries[0], sizeof(BookEntry), entries.size(), output);
+	}
+	fclose(output);
+
+	printf("Written %d book entries to %s\n", (int) entries.size(), filename);
+	return 0;
+}
@@ -0,0 +1,79 @@
+// Stand-in client of the analysis server, for testing it locally
+// Usage: client [-socket path]
+// Sends the lines of the standard input to the server and writes its responses to the standard output. At the end of the input
+// the client closes its side of the connection and waits until the server answers the queued requests and closes the other side.
+
+#include "configuration.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+
+// writes the responses of the server until it closes the connection
+static void ReadResponses(int fd)
+{
+	char buffer[4096];
+	for(;;)
+	{
+		const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+		if(received <= 0)
+			return;
+		fwrite(buffer, 1, (size_t) received, stdout);
+		fflush(stdout);
+	}
+}
+
+static bool SendAll(int fd, const char * data, size_t length)
+{
+	while(length > 0)
+	{
+		const ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+		if(sent <= 0)
+			return false;
+		data += sent;
+		length -= (size_t) sent;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const char * socketPath = Config::SERVER_SOCKET_FILENAME;
+	if(argc == 3 && strcmp(argv[1], "-socket") == 0)
+	{
+		socketPath = argv[2];
+	}
+	else if(argc != 1)
+	{
+		printf("Usage: client [-socket path]\n");
+		return 1;
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, (sockaddr *) &address, sizeof(address)) < 0)
+	{
+		printf("Could not connect to %s\n", socketPath);
+		return 1;
+	}
+
+	std::thread reader(ReadResponses, fd);
+
+	char line[4096];
+	while(fgets(line, sizeof(line), stdin))
+	{
+		if(!SendAll(fd, line, strlen(line)))
+			break;
+	}
+	shutdown(fd, SHUT_WR);
+
+	reader.join();
+	close(fd);
+	return 0;
+}
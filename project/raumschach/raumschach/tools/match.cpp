@@ -0,0 +1,510 @@
+// Headless match between two engine configurations, with the sequential probability ratio test (SPRT)
+// Usage: match [-engine1 options] [-engine2 options] [-games count] [-threads count] [-openings file] [-random plies]
+//              [-maxplies plies] [-seed seed] [-sprt elo0 elo1] [-alpha alpha] [-beta beta] [-log file]
+// The engine options are comma separated pairs "name=...,depth=...,nodes=...,hash=<MB>,nnue=<file>,tablebases=<directory>",
+// or "mcts=<playouts>,threads=<count>" for the monte carlo player (which ignores the alpha-beta options).
+// The games are played in pairs from the same opening with the colours swapped, the pairs are spread over the worker threads.
+// The openings are read from the file (a Notation position on every line), or made by random moves from the start position
+// and kept only if a short search finds them balanced. The games end by a mate, a stalemate, a repetition or the ply limit.
+// With -sprt the match stops as soon as the test accepts elo0 or elo1 (the elo of engine1 against engine2).
+// Every game is written to the log as a line "game opening white black result reason moves...".
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "mctsplayer.h"
+#include "notation.h"
+#include "nnue.h"
+#include "tablebase.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// the openings searched with this depth have to be within the margin to be balanced
+static const int OPENING_CHECK_DEPTH = 2;
+static const int BALANCED_OPENING_MARGIN = 2 * Const::PIECE_WORTH[Config::PAWN];
+static const int OPENING_ATTEMPTS = 100;
+
+struct EngineSettings
+{
+	std::string name;
+	int depth;
+	unsigned long long nodes;
+	int hashSize;
+	const NnueNetwork * network;
+	const Tablebases * tablebases;
+	int playouts; // the monte carlo player plays with this count of playouts, if it is not 0
+	int mctsThreads;
+};
+
+struct MatchSettings
+{
+	EngineSettings engines[2];
+	int games;
+	int randomPlies;
+	int maxPlies;
+	unsigned seed;
+	bool sprt;
+	double elo0;
+	double elo1;
+	double alpha;
+	double beta;
+	std::vector<std::string> openings;
+};
+
+enum GameResult
+{
+	GAME_WHITE_WIN,
+	GAME_DRAW,
+	GAME_BLACK_WIN,
+};
+
+// the shared results of the workers, counted for the engine1
+struct MatchOutput
+{
+	std::mutex lock;
+	FILE * log;
+	int wins;
+	int draws;
+	int losses;
+	bool finished; // the SPRT has accepted one of the hypotheses
+};
+
+static double EloToScore(double elo)
+{
+	return 1.0 / (1.0 + pow(10.0, - elo / 400.0));
+}
+
+// the log-likelihood ratio of the elo1 against the elo0 hypothesis, the normal approximation of the game results
+static double GetLogLikelihoodRatio(int wins, int draws, int losses, double elo0, double elo1)
+{
+	const double games = wins + draws + losses;
+	if(games == 0.0)
+		return 0.0;
+
+	const double score = (wins + 0.5 * draws) / games;
+	const double variance = (wins * (1.0 - score) * (1.0 - score) + draws * (0.5 - score) * (0.5 - score) + losses * score * score) / games;
+	// the same result of all the games says nothing about the spread yet
+	if(variance <= 0.0)
+		return 0.0;
+	const double score0 = EloToScore(elo0);
+	const double score1 = EloToScore(elo1);
+	return (score1 - score0) * (2.0 * score - score0 - score1) * games / (2.0 * variance);
+}
+
+// reads the engine options, the unknown options are reported
+static bool ParseEngine(const char * options, EngineSettings& engine)
+{
+	std::string text(options);
+	for(size_t start = 0; start < text.size(); )
+	{
+		size_t end = text.find(',', start);
+		if(end == std::string::npos)
+			end = text.size();
+		const std::string option = text.substr(start, end - start);
+		start = end + 1;
+
+		const size_t separator = option.find('=');
+		if(separator == std::string::npos)
+		{
+			printf("The engine option %s has no value\n", option.c_str());
+			return false;
+		}
+		const std::string key = option.substr(0, separator);
+		const std::string value = option.substr(separator + 1);
+
+		if(key == "name")
+			engine.name = value;
+		else if(key == "depth")
+			engine.depth = Utils::Max(1, atoi(value.c_str()));
+		else if(key == "nodes")
+			engine.nodes = strtoull(value.c_str(), nullptr, 10);
+		else if(key == "hash")
+			engine.hashSize = Utils::Max(1, atoi(value.c_str()));
+		else if(key == "mcts")
+			engine.playouts = Utils::Max(1, atoi(value.c_str()));
+		else if(key == "threads")
+			engine.mctsThreads = Utils::Max(1, atoi(value.c_str()));
+		else if(key == "nnue")
+		{
+			NnueNetwork * network = new NnueNetwork();
+			if(!network->Load(value.c_str()))
+			{
+				printf("Could not load the network %s\n", value.c_str());
+				delete network;
+				return false;
+			}
+			engine.network = network;
+		}
+		else if(key == "tablebases")
+		{
+			Tablebases * tablebases = new Tablebases();
+			if(tablebases->Load(value.c_str()) == 0)
+				printf("No tablebases found in %s\n", value.c_str());
+			engine.tablebases = tablebases;
+		}
+		else
+		{
+			printf("Unknown engine option %s\n", key.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+// the alpha-beta or the monte carlo player of the engine settings
+class MatchEngine
+{
+public:
+	MatchEngine(const EngineSettings& settings, unsigned seed, RandomGenerator * rgen)
+		:	alphaBeta(nullptr), mcts(nullptr)
+	{
+		if(settings.playouts)
+		{
+			mcts = new MCTSPlayer(settings.playouts, settings.mctsThreads, Config::WHITE, seed);
+			return;
+		}
+		alphaBeta = new AIPlayer(settings.depth, 0, Config::WHITE, rgen);
+		alphaBeta->SetNodeLimit(settings.nodes);
+		alphaBeta->SetTransitionTableSize(TransitionTable::GetSizeForMegabytes(settings.hashSize));
+		alphaBeta->SetNetwork(settings.network);
+		alphaBeta->SetTablebases(settings.tablebases);
+	}
+
+	~MatchEngine()
+	{
+		delete alphaBeta;
+		delete mcts;
+	}
+
+	Move Search(const Board& board, Config::PlayerColour colour) const
+	{
+		return (mcts ? mcts->Search(board, colour) : alphaBeta->Search(board, colour));
+	}
+
+	// the monte carlo player builds a new tree for every move anyway
+	void NewGame()
+	{
+		if(alphaBeta)
+			alphaBeta->NewGame();
+	}
+
+private:
+	// disable copy and assignment
+	MatchEngine(const MatchEngine& copy);
+	MatchEngine& operator=(const MatchEngine& assign);
+
+	AIPlayer * alphaBeta;
+	MCTSPlayer * mcts;
+};
+
+// makes the opening of the pair, from the file or by the random moves from the start position
+static bool GetOpening(const MatchSettings& settings, int pair, BitBoardMovePool * movePool, AIPlayer& checker, Board& board, Config::PlayerColour& colour)
+{
+	DynamicArray<Piece> pieces;
+	if(!settings.openings.empty())
+	{
+		if(!Notation::ParsePosition(settings.openings[pair % settings.openings.size()].c_str(), pieces, colour))
+			return false;
+		board = Board(pieces, movePool);
+		return true;
+	}
+
+	RandomGenerator rgen(settings.seed + (unsigned) pair);
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	for(int attempt = 0; attempt < OPENING_ATTEMPTS; ++attempt)
+	{
+		board = Board(DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), movePool);
+		colour = Config::WHITE;
+		for(int ply = 0; ply < settings.randomPlies; ++ply)
+		{
+			moves.Clear();
+			board.GetPossibleMoves(colour, moves);
+			if(moves.Count() == 0)
+				break;
+			const Move& move = moves[rgen.GetRand(moves.Count())];
+			board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+			colour = Config::GetOppositePlayer(colour);
+		}
+
+		if(board.KingCheckState(colour) != Config::NORMAL)
+			continue;
+		checker.NewGame();
+		const Move best = checker.Search(board, colour);
+		if(Utils::Abs(best.heuristic) <= BALANCED_OPENING_MARGIN)
+			return true;
+	}
+	return false;
+}
+
+// plays the game from the opening, the played moves are written to the moves text
+static GameResult PlayGame(const MatchSettings& settings, Board board, Config::PlayerColour colour, MatchEngine * players[Config::PCOLOUR_COUNT],
+	std::string& moves, const char *& reason)
+{
+	for(int ply = 0; ply < settings.maxPlies; ++ply)
+	{
+		const Config::KingState state = board.KingCheckState(colour);
+		if(state == Config::CHECKMATE)
+		{
+			reason = "mate";
+			return (colour == Config::WHITE ? GAME_BLACK_WIN : GAME_WHITE_WIN);
+		}
+		else if(state == Config::STALEMATE || state == Config::NO_KING)
+		{
+			reason = "stalemate";
+			return GAME_DRAW;
+		}
+		else if(board.IsRepetition())
+		{
+			reason = "repetition";
+			return GAME_DRAW;
+		}
+
+		const Move move = players[colour]->Search(board, colour);
+		if(move.piece.GetType() == Config::NO_TYPE)
+		{
+			reason = "stalemate";
+			return GAME_DRAW;
+		}
+
+		char text[Notation::MOVE_LENGTH + 1];
+		Notation::FormatMove(move, text);
+		moves += ' ';
+		moves += text;
+
+		board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+		colour = Config::GetOppositePlayer(colour);
+	}
+
+	reason = "maxplies";
+	return GAME_DRAW;
+}
+
+static void PlayPairs(const MatchSettings& settings, BitBoardMovePool * movePool, std::atomic<int>& nextPair, MatchOutput& output)
+{
+	RandomGenerator rgen(settings.seed);
+	AIPlayer checker(OPENING_CHECK_DEPTH, 0, Config::WHITE, &rgen);
+	MatchEngine * engines[2];
+	for(int e = 0; e < 2; ++e)
+	{
+		engines[e] = new MatchEngine(settings.engines[e], settings.seed + (unsigned) e, &rgen);
+	}
+
+	const int pairCount = (settings.games + 1) / 2;
+	for(int pair = nextPair++; pair < pairCount; pair = nextPair++)
+	{
+		{
+			std::lock_guard<std::mutex> lock(output.lock);
+			if(output.finished)
+				break;
+		}
+
+		Board opening;
+		Config::PlayerColour colour = Config::WHITE;
+		if(!GetOpening(settings, pair, movePool, checker, opening, colour))
+		{
+			printf("No opening for the pair %d\n", pair + 1);
+			continue;
+		}
+		const CharString openingText = Notation::FormatPosition(opening, colour);
+
+		// the engine1 is white in the first game of the pair and black in the second one
+		for(int swap = 0; swap < 2 && pair * 2 + swap < settings.games; ++swap)
+		{
+			MatchEngine * players[Config::PCOLOUR_COUNT];
+			players[Config::WHITE] = engines[swap];
+			players[Config::BLACK] = engines[1 - swap];
+			engines[0]->NewGame();
+			engines[1]->NewGame();
+
+			std::string moves;
+			const char * reason = "";
+			const GameResult result = PlayGame(settings, opening, colour, players, moves, reason);
+
+			std::lock_guard<std::mutex> lock(output.lock);
+			const bool engine1White = (swap == 0);
+			if(result == GAME_DRAW)
+				output.draws++;
+			else if((result == GAME_WHITE_WIN) == engine1White)
+				output.wins++;
+			else
+				output.losses++;
+
+			static const char * const RESULT_TEXTS[] = { "1-0", "1/2-1/2", "0-1" };
+			if(output.log)
+			{
+				fprintf(output.log, "%d \"%s\" %s %s %s %s%s\n", pair * 2 + swap + 1, openingText.GetPtr(),
+					settings.engines[swap].name.c_str(), settings.engines[1 - swap].name.c_str(), RESULT_TEXTS[result], reason, moves.c_str());
+				fflush(output.log);
+			}
+
+			const int games = output.wins + output.draws + output.losses;
+			const double score = (output.wins + 0.5 * output.draws) / games;
+			const double elo = (score > 0.0 && score < 1.0 ? -400.0 * log10(1.0 / score - 1.0) : (score > 0.0 ? 999.0 : -999.0));
+			printf("Game %d: %s, %s +%d =%d -%d, score %.1f%%, elo %.1f", games, RESULT_TEXTS[result], settings.engines[0].name.c_str(),
+				output.wins, output.draws, output.losses, score * 100.0, elo);
+
+			if(settings.sprt && !output.finished)
+			{
+				const double llr = GetLogLikelihoodRatio(output.wins, output.draws, output.losses, settings.elo0, settings.elo1);
+				const double lowerBound = log(settings.beta / (1.0 - settings.alpha));
+				const double upperBound = log((1.0 - settings.beta) / settings.alpha);
+				printf(", LLR %.2f (%.2f, %.2f)", llr, lowerBound, upperBound);
+				if(llr >= upperBound || llr <= lowerBound)
+				{
+					output.finished = true;
+					printf("\nSPRT accepted %s: elo %s %.1f\n", (llr >= upperBound ? "H1" : "H0"), (llr >= upperBound ? ">=" : "<="),
+						(llr >= upperBound ? settings.elo1 : settings.elo0));
+				}
+			}
+			printf("\n");
+		}
+	}
+
+	delete engines[0];
+	delete engines[1];
+}
+
+int main(int argc, char **argv)
+{
+	MatchSettings settings;
+	for(int e = 0; e < 2; ++e)
+	{
+		settings.engines[e].name = (e == 0 ? "engine1" : "engine2");
+		settings.engines[e].depth = 2;
+		settings.engines[e].nodes = 0ULL;
+		settings.engines[e].hashSize = 2;
+		settings.engines[e].network = nullptr;
+		settings.engines[e].tablebases = nullptr;
+		settings.engines[e].playouts = 0;
+		settings.engines[e].mctsThreads = 1;
+	}
+	settings.games = 100;
+	settings.randomPlies = 4;
+	settings.maxPlies = 300;
+	settings.seed = 1;
+	settings.sprt = false;
+	settings.elo0 = 0.0;
+	settings.elo1 = 10.0;
+	settings.alpha = 0.05;
+	settings.beta = 0.05;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	const char * openingsName = nullptr;
+	const char * logName = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if(strcmp(argv[i], "-engine1") == 0 && hasValue)
+		{
+			if(!ParseEngine(argv[++i], settings.engines[0]))
+				return 1;
+		}
+		else if(strcmp(argv[i], "-engine2") == 0 && hasValue)
+		{
+			if(!ParseEngine(argv[++i], settings.engines[1]))
+				return 1;
+		}
+		else if(strcmp(argv[i], "-games") == 0 && hasValue)
+			settings.games = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-threads") == 0 && hasValue)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-openings") == 0 && hasValue)
+			openingsName = argv[++i];
+		else if(strcmp(argv[i], "-random") == 0 && hasValue)
+			settings.randomPlies = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-maxplies") == 0 && hasValue)
+			settings.maxPlies = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-seed") == 0 && hasValue)
+			settings.seed = (unsigned) strtoul(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "-sprt") == 0 && i + 2 < argc)
+		{
+			settings.sprt = true;
+			settings.elo0 = atof(argv[++i]);
+			settings.elo1 = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-alpha") == 0 && hasValue)
+			settings.alpha = atof(argv[++i]);
+		else if(strcmp(argv[i], "-beta") == 0 && hasValue)
+			settings.beta = atof(argv[++i]);
+		else if(strcmp(argv[i], "-log") == 0 && hasValue)
+			logName = argv[++i];
+		else
+		{
+			printf("Usage: match [-engine1 options] [-engine2 options] [-games count] [-threads count] [-openings file] [-random plies]\n"
+				"             [-maxplies plies] [-seed seed] [-sprt elo0 elo1] [-alpha alpha] [-beta beta] [-log file]\n");
+			return 1;
+		}
+	}
+	settings.games = Utils::Max(1, settings.games);
+	threadCount = Utils::Max(1, threadCount);
+
+	if(openingsName)
+	{
+		FILE * input = fopen(openingsName, "r");
+		if(!input)
+		{
+			printf("Could not open the openings file %s\n", openingsName);
+			return 1;
+		}
+		char line[4096];
+		while(fgets(line, sizeof(line), input))
+		{
+			line[strcspn(line, "\r\n")] = '\0';
+			if(line[0] != '\0' && line[0] != '#')
+				settings.openings.push_back(line);
+		}
+		fclose(input);
+		if(settings.openings.empty())
+		{
+			printf("No openings in %s\n", openingsName);
+			return 1;
+		}
+	}
+
+	MatchOutput output;
+	output.log = nullptr;
+	output.wins = output.draws = output.losses = 0;
+	output.finished = false;
+	if(logName && !(output.log = fopen(logName, "w")))
+	{
+		printf("Could not open the log file %s\n", logName);
+		return 1;
+	}
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	std::atomic<int> nextPair(0);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads.push_back(std::thread(PlayPairs, std::cref(settings), &movePool, std::ref(nextPair), std::ref(output)));
+	}
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads[t].join();
+	}
+
+	if(output.log)
+	{
+		fclose(output.log);
+	}
+	printf("Finished %d games: %s +%d =%d -%d %s\n", output.wins + output.draws + output.losses, settings.engines[0].name.c_str(),
+		output.wins, output.draws, output.losses, settings.engines[1].name.c_str());
+
+	for(int e = 0; e < 2; ++e)
+	{
+		delete settings.engines[e].network;
+		delete settings.engines[e].tablebases;
+	}
+	return 0;
+}
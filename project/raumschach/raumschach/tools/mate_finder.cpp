@@ -0,0 +1,135 @@
+// Searches the saved board for a forced mate of the player on move
+// Usage: mate_finder [-moves count] [-compare] [-pns] [-tree] [-position position] [board_file]
+// The board file has the format of the board save button (the game state flags followed by the pieces), or the position is
+// given in the Notation. The mate is searched with checking moves only, -compare runs also the full alpha-beta search of the
+// same depth for the node counts. -pns solves the position with the proof-number search instead, -tree writes its proof tree.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "proofsearch.h"
+#include "notation.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctime>
+
+static bool LoadBoard(const char * filename, DynamicArray<Piece>& pieces, Config::PlayerColour& colourToMove)
+{
+	FILE * input = fopen(filename, "rb");
+	if(!input)
+		return false;
+
+	unsigned short flags = 0;
+	const bool valid = fread(&flags, sizeof(flags), 1, input) == 1;
+
+	Piece inputPiece;
+	while(valid && fread(&inputPiece, sizeof(Piece), 1, input))
+	{
+		pieces += inputPiece;
+	}
+	fclose(input);
+
+	colourToMove = (Config::PlayerColour) ((flags >> Config::BOARD_STATE_TURN_COLOUR_LSHIFT) & 0x0003);
+	return valid && colourToMove != Config::BOTH_COLOURS;
+}
+
+static float GetSeconds(long long start)
+{
+	return (float) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	int maxMoves = 3;
+	bool compare = false;
+	bool proofSearch = false;
+	bool printTree = false;
+	const char * position = nullptr;
+	const char * filename = Config::BOARD_SAVE_FILENAME;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-moves") == 0 && i + 1 < argc)
+			maxMoves = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-compare") == 0)
+			compare = true;
+		else if(strcmp(argv[i], "-pns") == 0)
+			proofSearch = true;
+		else if(strcmp(argv[i], "-tree") == 0)
+			printTree = true;
+		else if(strcmp(argv[i], "-position") == 0 && i + 1 < argc)
+			position = argv[++i];
+		else
+			filename = argv[i];
+	}
+	maxMoves = Utils::Max(1, Utils::Min(maxMoves, Config::MAX_SEARCH_PLY / 2));
+
+	DynamicArray<Piece> pieces;
+	Config::PlayerColour colour = Config::WHITE;
+	if(position ? !Notation::ParsePosition(position, pieces, colour) : !LoadBoard(filename, pieces, colour))
+	{
+		printf("Could not load the board from %s\n", (position ? position : filename));
+		return 1;
+	}
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+	Board board(pieces, &movePool);
+	RandomGenerator rgen(1);
+
+	AIPlayer mateSearcher(1, 0, colour, &rgen);
+	Move mateMove;
+	int mateMoves = 0;
+	long long start = clock();
+	if(proofSearch)
+	{
+		ProofNumberSearch solver;
+		const ProofResult result = solver.Solve(board, colour, maxMoves);
+		mateMoves = solver.GetMateMoves();
+		mateMove = solver.GetProofMove();
+		printf("Proof-number search: %s, %llu positions expanded, %d nodes at most, %.2fs\n",
+			(result == PROOF_PROVED ? "proved" : (result == PROOF_DISPROVED ? "disproved" : "out of nodes")),
+			solver.GetExpandedCount(), solver.GetPeakNodes(), GetSeconds(start));
+		if(printTree)
+		{
+			solver.PrintProofTree(stdout);
+		}
+	}
+	else
+	{
+		mateMoves = mateSearcher.FindMate(board, colour, maxMoves, mateMove);
+	}
+	const float mateSeconds = GetSeconds(start);
+
+	if(mateMoves)
+	{
+		printf("%s mates in %d: %s to (%d, %d, %d)\n", Const::COLOUR_NAMES[colour].GetPtr(), mateMoves, Const::PIECE_NAMES[mateMove.piece.GetType()].GetPtr(),
+			mateMove.destination.x, mateMove.destination.y, mateMove.destination.z);
+	}
+	else
+	{
+		printf("No mate with checks in %d moves for %s\n", maxMoves, Const::COLOUR_NAMES[colour].GetPtr());
+	}
+	if(!proofSearch)
+	{
+		printf("Mate search: %llu nodes, %.2fs\n", mateSearcher.GetSearchStats().nodes, mateSeconds);
+	}
+
+	if(compare)
+	{
+		// the full search recognizes the mate only on the ply of the mated player, one after the last mating move
+		const int depth = (mateMoves ? mateMoves : maxMoves) * 2;
+		AIPlayer searcher(depth, 0, colour, &rgen);
+		start = clock();
+		const Move best = searcher.Search(board, colour);
+		const float searchSeconds = GetSeconds(start);
+
+		printf("Full search (depth %d): %s to (%d, %d, %d), h = %d, %llu nodes, %.2fs\n", depth, Const::PIECE_NAMES[best.piece.GetType()].GetPtr(),
+			best.destination.x, best.destination.y, best.destination.z, best.heuristic, searcher.GetSearchStats().nodes, searchSeconds);
+	}
+
+	return 0;
+}
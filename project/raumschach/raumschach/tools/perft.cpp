@@ -0,0 +1,231 @@
+// Counts the leaf nodes of the move generation tree (perft) to validate and time the move generator
+// Usage: perft [-threads count] [-hash entries] [-divide] [-position "position"] depth
+// The root moves are split between the threads, every thread has its own board and (optional) hash table of the counted
+// subtrees. -divide prints the count of every root move. The start position counts are checked against the reference ones.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "notation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// the counts of the start position (Const::INITIAL_PIECES with white on move) from depth 1
+static const unsigned long long START_POSITION_COUNTS[] = { 61ULL, 3615ULL, 237315ULL, 15583834ULL, 1099948045ULL };
+
+// Direct mapped table of the counted subtrees, keyed by the position hash and the depth
+class PerftHashTable
+{
+public:
+	PerftHashTable(int size) : entries(nullptr), mask(0ULL)
+	{
+		int entryCount = 1;
+		while(entryCount * 2 <= size)
+		{
+			entryCount *= 2;
+		}
+		entries = new PerftEntry[entryCount];
+		mask = (unsigned long long) (entryCount - 1);
+		for(int i = 0; i < entryCount; ++i)
+		{
+			entries[i].hash = 0ULL;
+			entries[i].depth = 0;
+			entries[i].count = 0ULL;
+		}
+	}
+
+	~PerftHashTable()
+	{
+		delete[] entries;
+		entries = nullptr;
+	}
+
+	inline bool GetCount(unsigned long long hash, int depth, unsigned long long& count) const
+	{
+		const PerftEntry& entry = entries[GetIndex(hash, depth)];
+		if(entry.hash == hash && entry.depth == depth)
+		{
+			count = entry.count;
+			return true;
+		}
+		return false;
+	}
+
+	inline void AddCount(unsigned long long hash, int depth, unsigned long long count)
+	{
+		PerftEntry& entry = entries[GetIndex(hash, depth)];
+		entry.hash = hash;
+		entry.depth = depth;
+		entry.count = count;
+	}
+
+private:
+	// disable copy and assignment
+	PerftHashTable(const PerftHashTable& copy);
+	PerftHashTable& operator=(const PerftHashTable& assign);
+
+	// the same position with different depths goes to different entries
+	inline unsigned long long GetIndex(unsigned long long hash, int depth) const
+	{
+		return (hash ^ ((unsigned long long) depth * 0x9E3779B97F4A7C15ULL)) & mask;
+	}
+
+	struct PerftEntry
+	{
+		unsigned long long hash;
+		int depth;
+		unsigned long long count;
+	};
+
+	PerftEntry * entries;
+	unsigned long long mask;
+};
+
+static unsigned long long Perft(Board& board, Config::PlayerColour colour, int depth, DynamicArray<Move> * plyMoves, PerftHashTable * table)
+{
+	DynamicArray<Move>& moves = plyMoves[depth];
+	moves.Clear();
+	board.GetPossibleMoves(colour, moves);
+
+	// the generated moves are legal, so the last ply doesn't have to be made
+	if(depth == 1)
+		return (unsigned long long) moves.Count();
+
+	const unsigned long long hash = board.GetPositionHash(colour);
+	unsigned long long count = 0ULL;
+	if(table && table->GetCount(hash, depth, count))
+		return count;
+
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
+		count += Perft(board, oppositeColour, depth - 1, plyMoves, table);
+		board.UndoMove(move);
+	}
+
+	if(table)
+		table->AddCount(hash, depth, count);
+	return count;
+}
+
+static void PerftRootMoves(const Board& rootBoard, Config::PlayerColour colour, int depth, int hashSize, const DynamicArray<Move>& rootMoves,
+	std::vector<unsigned long long>& counts, std::atomic<int>& nextMove)
+{
+	Board board(rootBoard);
+	PerftHashTable * table = (hashSize > 0 ? new PerftHashTable(hashSize) : nullptr);
+	DynamicArray<Move> * plyMoves = new DynamicArray<Move>[depth + 1];
+	for(int i = 0; i <= depth; ++i)
+	{
+		plyMoves[i].Alloc(Const::MAX_PIECES_MOVES);
+	}
+
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	for(int i = nextMove++; i < rootMoves.Count(); i = nextMove++)
+	{
+		if(depth == 1)
+		{
+			counts[i] = 1ULL;
+			continue;
+		}
+
+		MadeMove move = board.MovePiece(rootMoves[i].piece, rootMoves[i].destination, rootMoves[i].pieceMoves, true);
+		counts[i] = Perft(board, oppositeColour, depth - 1, plyMoves, table);
+		board.UndoMove(move);
+	}
+
+	delete[] plyMoves;
+	delete table;
+}
+
+int main(int argc, char **argv)
+{
+	int depth = 0;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	int hashSize = 0;
+	bool divide = false;
+	const char * position = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-hash") == 0 && i + 1 < argc)
+			hashSize = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-divide") == 0)
+			divide = true;
+		else if(strcmp(argv[i], "-position") == 0 && i + 1 < argc)
+			position = argv[++i];
+		else
+			depth = atoi(argv[i]);
+	}
+
+	if(depth <= 0)
+	{
+		printf("Usage: perft [-threads count] [-hash entries] [-divide] [-position \"position\"] depth\n");
+		return 1;
+	}
+	threadCount = Utils::Max(1, threadCount);
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	DynamicArray<Piece> pieces;
+	Config::PlayerColour colour = Config::WHITE;
+	if(!position)
+	{
+		pieces = DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES));
+	}
+	else if(!Notation::ParsePosition(position, pieces, colour))
+	{
+		printf("The position is not valid\n");
+		return 1;
+	}
+
+	Board board(pieces, &movePool);
+	DynamicArray<Move> rootMoves(Const::MAX_PIECES_MOVES);
+	board.GetPossibleMoves(colour, rootMoves);
+
+	std::vector<unsigned long long> counts(rootMoves.Count(), 0ULL);
+	std::atomic<int> nextMove(0);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads.push_back(std::thread(PerftRootMoves, std::cref(board), colour, depth, hashSize, std::cref(rootMoves), std::ref(counts), std::ref(nextMove)));
+	}
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads[t].join();
+	}
+	const long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	unsigned long long total = 0ULL;
+	for(int i = 0; i < rootMoves.Count(); ++i)
+	{
+		if(divide)
+		{
+			char move[Notation::MOVE_LENGTH + 1];
+			Notation::FormatMove(rootMoves[i], move);
+			printf("%s: %llu\n", move, counts[i]);
+		}
+		total += counts[i];
+	}
+
+	printf("Depth %d: %llu nodes, %lld ms, %llu nodes/second\n", depth, total, milliseconds, total * 1000ULL / (unsigned long long) Utils::Max(milliseconds, 1LL));
+
+	const int referenceCount = COUNT_OF(START_POSITION_COUNTS);
+	if(!position && depth <= referenceCount && START_POSITION_COUNTS[depth - 1])
+	{
+		const bool match = (total == START_POSITION_COUNTS[depth - 1]);
+		printf("Reference count %llu: %s\n", START_POSITION_COUNTS[depth - 1], match ? "OK" : "MISMATCH");
+		return match ? 0 : 1;
+	}
+	return 0;
+}
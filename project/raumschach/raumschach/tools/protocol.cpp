@@ -0,0 +1,33 @@
+// Runs the text protocol of the engine (see ProtocolEngine) over the standard input and output
+// Usage: protocol
+// The commands are read line by line, the search runs in the background so "stop" is handled while it searches.
+// At the end of the input the running search is finished (the infinite one is stopped) before the program ends.
+
+#include "protocol.h"
+#include <stdio.h>
+
+class StdoutOutput : public ProtocolOutput
+{
+public:
+	void WriteLine(const char * line)
+	{
+		printf("%s\n", line);
+		fflush(stdout);
+	}
+};
+
+int main()
+{
+	StdoutOutput output;
+	ProtocolEngine engine(&output);
+
+	char line[4096];
+	while(fgets(line, sizeof(line), stdin))
+	{
+		if(!engine.HandleCommand(line))
+			return 0;
+	}
+
+	engine.WaitForSearch();
+	return 0;
+}
@@ -0,0 +1,231 @@
+// Headless self-play generator of labeled positions for the evaluation tuning
+// Usage: selfplay [-games count] [-depth depth] [-nodes count] [-threads count] [-random plies] [-maxplies plies] [-seed seed] [-append] output_file
+// Every worker thread plays whole games with its own board and ai player. The games start with a few random moves,
+// then both players search with the fixed depth (or node budget). Every position after the opening is written with the search score
+// and the final game result as a PositionRecord, the records of a game are written together when it ends.
+// Every game has its own seed and starts with empty search tables, and the games are written in their order,
+// so the output file is the same for the same settings whatever the thread count.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "positionrecord.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+struct SelfPlaySettings
+{
+	int games;
+	int depth;
+	unsigned long long nodes;
+	int randomPlies;
+	int maxPlies;
+	unsigned seed;
+};
+
+// a played game waiting for the previous games to be written
+struct SelfPlayGame
+{
+	PositionResult result;
+	std::vector<PositionRecord> records;
+};
+
+// the shared output of the workers
+struct SelfPlayOutput
+{
+	PositionRecordWriter writer;
+	std::mutex lock;
+	std::map<int, SelfPlayGame> pendingGames; // the finished games that are after the next written one
+	int nextWrittenGame;
+	int finishedGames;
+	int positions;
+	int results[3];
+};
+
+static short ClampScore(int score)
+{
+	return (short) Utils::Min(Utils::Max(score, -32767), 32767);
+}
+
+// plays a single game and returns its result, the records of the game are appended to records
+static PositionResult PlayGame(const SelfPlaySettings& settings, BitBoardMovePool * movePool, RandomGenerator& rgen, AIPlayer& searcher, std::vector<PositionRecord>& records)
+{
+	Board board(DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), movePool);
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	Config::PlayerColour colour = Config::WHITE;
+
+	for(int ply = 0; ply < settings.maxPlies; ++ply)
+	{
+		const Config::KingState state = board.KingCheckState(colour);
+		if(state == Config::CHECKMATE)
+		{
+			return (colour == Config::WHITE ? RESULT_BLACK_WIN : RESULT_WHITE_WIN);
+		}
+		else if(state == Config::STALEMATE || state == Config::NO_KING)
+		{
+			return RESULT_DRAW;
+		}
+		else if(board.IsRepetition())
+		{
+			// the search scores the repetitions as draws, so the game would only cycle through the recorded positions
+			return RESULT_DRAW;
+		}
+
+		Move move;
+		if(ply < settings.randomPlies)
+		{
+			moves.Clear();
+			board.GetPossibleMoves(colour, moves);
+			move = moves[rgen.GetRand(moves.Count())];
+		}
+		else
+		{
+			move = searcher.Search(board, colour);
+
+			// the positions in check are not quiet, so they are not worth learning from
+			if(state != Config::CHECK)
+			{
+				PositionRecord record;
+				if(record.FromBoard(board, colour))
+				{
+					record.score = ClampScore(colour == Config::WHITE ? move.heuristic : -move.heuristic);
+					records.push_back(record);
+				}
+			}
+		}
+
+		board.MovePiece(move.piece, move.destination, move.pieceMoves, true);
+		colour = Config::GetOppositePlayer(colour);
+	}
+
+	// too long games are adjudicated as draws
+	return RESULT_DRAW;
+}
+
+static void PlayGames(const SelfPlaySettings& settings, BitBoardMovePool * movePool, std::atomic<int>& nextGame, SelfPlayOutput& output)
+{
+	RandomGenerator rgen;
+	AIPlayer searcher(settings.depth, 0, Config::WHITE, &rgen);
+	searcher.SetNodeLimit(settings.nodes);
+
+	for(int game = nextGame++; game < settings.games; game = nextGame++)
+	{
+		rgen.Seed(settings.seed + (unsigned) game);
+		searcher.NewGame();
+
+		SelfPlayGame played;
+		played.result = PlayGame(settings, movePool, rgen, searcher, played.records);
+
+		std::lock_guard<std::mutex> lock(output.lock);
+		output.positions += (int) played.records.size();
+		output.results[played.result]++;
+		output.finishedGames++;
+		printf("Game %d/%d finished: +%d =%d -%d, %d positions\n", output.finishedGames, settings.games,
+			output.results[RESULT_WHITE_WIN], output.results[RESULT_DRAW], output.results[RESULT_BLACK_WIN], output.positions);
+
+		// the games are written in their order, the ones finished too early wait for the previous ones
+		output.pendingGames[game] = played;
+		for(auto pending = output.pendingGames.find(output.nextWrittenGame); pending != output.pendingGames.end(); pending = output.pendingGames.find(output.nextWrittenGame))
+		{
+			std::vector<PositionRecord>& records = pending->second.records;
+			for(size_t i = 0; i < records.size(); ++i)
+			{
+				records[i].result = (unsigned char) pending->second.result;
+				output.writer.Write(records[i]);
+			}
+			output.pendingGames.erase(pending);
+			output.nextWrittenGame++;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	SelfPlaySettings settings;
+	settings.games = 100;
+	settings.depth = 2;
+	settings.nodes = 0ULL;
+	settings.randomPlies = 6;
+	settings.maxPlies = 300;
+	settings.seed = 1;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	bool append = false;
+	bool depthSet = false;
+	const char * filename = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-games") == 0 && i + 1 < argc)
+			settings.games = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-depth") == 0 && i + 1 < argc)
+		{
+			settings.depth = atoi(argv[++i]);
+			depthSet = true;
+		}
+		else if(strcmp(argv[i], "-nodes") == 0 && i + 1 < argc)
+			settings.nodes = strtoull(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-random") == 0 && i + 1 < argc)
+			settings.randomPlies = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-maxplies") == 0 && i + 1 < argc)
+			settings.maxPlies = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+			settings.seed = (unsigned) strtoul(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "-append") == 0)
+			append = true;
+		else
+			filename = argv[i];
+	}
+
+	if(!filename)
+	{
+		printf("Usage: selfplay [-games count] [-depth depth] [-nodes count] [-threads count] [-random plies] [-maxplies plies] [-seed seed] [-append] output_file\n");
+		return 1;
+	}
+
+	// the node budget deepens the search up to the depth, so without an explicit depth it is the deepest one
+	if(settings.nodes && !depthSet)
+	{
+		settings.depth = Config::MAX_AI_PLAYER_SEARCH_DEPTH;
+	}
+	settings.depth = Utils::Max(1, settings.depth);
+	threadCount = Utils::Max(1, threadCount);
+
+	SelfPlayOutput output;
+	output.nextWrittenGame = 0;
+	output.finishedGames = 0;
+	output.positions = 0;
+	output.results[RESULT_BLACK_WIN] = output.results[RESULT_DRAW] = output.results[RESULT_WHITE_WIN] = 0;
+	if(!output.writer.Open(filename, append))
+	{
+		printf("Could not open the output file %s\n", filename);
+		return 1;
+	}
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	std::atomic<int> nextGame(0);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads.push_back(std::thread(PlayGames, std::cref(settings), &movePool, std::ref(nextGame), std::ref(output)));
+	}
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads[t].join();
+	}
+
+	output.writer.Close();
+	printf("Written %d positions from %d games to %s\n", output.positions, output.finishedGames, filename);
+	return 0;
+}
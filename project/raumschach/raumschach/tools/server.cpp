@@ -0,0 +1,466 @@
+// Analysis server on a unix domain socket, for many clients querying the engine at once
+// Usage: server [-socket path] [-threads count] [-hash megabytes]
+// Every connection has its own position (a board with its move history) and sends line based commands:
+//   position startpos|<position> [moves <move>...]  - sets the position of the connection (in the Notation)
+//   go [depth <plies>] [nodes <count>] [movetime <ms>] [infinite]
+//                                                      - queues the analysis of the position, answered by "queued <id>"
+//                                                        (the infinite analysis runs until it is cancelled)
+//   cancel [<id>]                                      - cancels the request (or all the requests of the connection)
+//   isready                                            - answered by "readyok"
+//   quit                                               - cancels the requests and closes the connection
+// Every request ends with a single line "result <id> <move> <score> <depth> <nodes>", or "result <id> cancelled" if it was
+// cancelled before it started. A cancelled or timed out search answers with its last finished depth.
+// The requests are searched by a fixed pool of workers, all of them sharing one large transition table. The connection stays
+// open after the client closes its side until its requests are answered, so a client can send its commands and read the results.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "player.h"
+#include "notation.h"
+#include "random_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+static const int MAX_LINE_LENGTH = 4096;
+// the period of the checks of the search time limits
+static const int POLL_TIMEOUT_MS = 5;
+
+static volatile sig_atomic_t shutdownRequested = 0;
+
+static void OnSignal(int)
+{
+	shutdownRequested = 1;
+}
+
+// The client connection, kept alive by its requests until they are answered
+struct ServerConnection
+{
+	ServerConnection(int socket, BitBoardMovePool * movePool)
+		:	fd(socket), board(DynamicArray<Piece>(Const::INITIAL_PIECES, COUNT_OF(Const::INITIAL_PIECES)), movePool), colour(Config::WHITE),
+			nextRequestId(1), closed(false)
+	{}
+
+	~ServerConnection()
+	{
+		close(fd);
+	}
+
+	void WriteLine(const char * line)
+	{
+		std::lock_guard<std::mutex> lock(writeLock);
+		if(closed)
+			return;
+
+		std::string text(line);
+		text += '\n';
+		for(size_t sent = 0; sent < text.size(); )
+		{
+			const ssize_t written = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+			if(written <= 0)
+			{
+				if(written < 0 && errno == EINTR)
+					continue;
+				closed = true;
+				return;
+			}
+			sent += (size_t) written;
+		}
+	}
+
+	const int fd;
+	std::string input; // the received characters of the unfinished line
+	// the position of the connection, the board keeps its history for the repetitions
+	Board board;
+	Config::PlayerColour colour;
+	int nextRequestId;
+	std::mutex writeLock;
+	std::atomic<bool> closed;
+
+private:
+	// disable copy and assignment
+	ServerConnection(const ServerConnection& copy);
+	ServerConnection& operator=(const ServerConnection& assign);
+};
+
+struct AnalysisRequest
+{
+	std::shared_ptr<ServerConnection> connection;
+	int id;
+	Board board;
+	Config::PlayerColour colour;
+	int depth;
+	unsigned long long nodes;
+	long long moveTime;
+	std::chrono::steady_clock::time_point deadline; // set when the search starts
+	std::atomic<bool> stop;
+};
+
+// the state shared by the connections and the workers
+struct ServerState
+{
+	BitBoardMovePool movePool;
+	TransitionTable * table;
+	std::mutex lock;
+	std::condition_variable requestQueued;
+	std::deque<std::shared_ptr<AnalysisRequest> > pending;
+	std::vector<std::shared_ptr<AnalysisRequest> > running;
+	bool stopping;
+};
+
+static void WriteCancelled(const AnalysisRequest& request)
+{
+	char line[64];
+	snprintf(line, sizeof(line), "result %d cancelled", request.id);
+	request.connection->WriteLine(line);
+}
+
+static void RunWorker(ServerState& state, int worker)
+{
+	RandomGenerator rgen(Config::DETERMINISTIC_SEED + (unsigned) worker);
+	AIPlayer searcher(Config::AI_PLAYER_SEARCH_DEPTH, 0, Config::WHITE, &rgen);
+	searcher.SetSharedTransitionTable(state.table);
+	const DynamicArray<Move> allMoves(1);
+
+	for(;;)
+	{
+		std::shared_ptr<AnalysisRequest> request;
+		{
+			std::unique_lock<std::mutex> lock(state.lock);
+			state.requestQueued.wait(lock, [&state]() { return !state.pending.empty() || state.stopping; });
+			if(state.pending.empty())
+				return;
+
+			request = state.pending.front();
+			state.pending.pop_front();
+			request->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(request->moveTime);
+			state.running.push_back(request);
+		}
+
+		searcher.SetStopFlag(&request->stop);
+		searcher.SetNodeLimit(request->nodes);
+		const Move best = searcher.Search(request->board, request->colour, request->depth, allMoves);
+		const SearchStats& stats = searcher.GetSearchStats();
+
+		{
+			std::lock_guard<std::mutex> lock(state.lock);
+			for(size_t i = 0; i < state.running.size(); ++i)
+			{
+				if(state.running[i] == request)
+				{
+					state.running.erase(state.running.begin() + i);
+					break;
+				}
+			}
+		}
+
+		// without a move the player is mated or it is a stalemate
+		char move[Notation::MOVE_LENGTH + 1] = "0000";
+		int score = (request->board.KingInCheck(request->colour) ? - Config::MATE_SCORE : 0);
+		if(best.piece.GetType() != Config::NO_TYPE)
+		{
+			Notation::FormatMove(best, move);
+			score = best.heuristic;
+		}
+
+		char line[MAX_LINE_LENGTH];
+		snprintf(line, sizeof(line), "result %d %s %d %d %llu", request->id, move, score, stats.depth, stats.nodes);
+		request->connection->WriteLine(line);
+	}
+}
+
+// cancels the request with the id (or all of them if the id is 0) of the connection
+static void CancelRequests(ServerState& state, const ServerConnection * connection, int id)
+{
+	std::vector<std::shared_ptr<AnalysisRequest> > cancelled;
+	{
+		std::lock_guard<std::mutex> lock(state.lock);
+		for(size_t i = 0; i < state.pending.size(); )
+		{
+			if(state.pending[i]->connection.get() == connection && (id == 0 || state.pending[i]->id == id))
+			{
+				cancelled.push_back(state.pending[i]);
+				state.pending.erase(state.pending.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+		for(size_t i = 0; i < state.running.size(); ++i)
+		{
+			if(state.running[i]->connection.get() == connection && (id == 0 || state.running[i]->id == id))
+				state.running[i]->stop = true;
+		}
+	}
+
+	for(size_t i = 0; i < cancelled.size(); ++i)
+	{
+		WriteCancelled(*cancelled[i]);
+	}
+}
+
+static void SetPosition(ServerState& state, ServerConnection& connection, const std::vector<const char *>& tokens)
+{
+	CharString error;
+	if(!Notation::ParsePositionCommand(tokens, &state.movePool, connection.board, connection.colour, error))
+	{
+		connection.WriteLine(CharString("error ") + error);
+	}
+}
+
+static void QueueRequest(ServerState& state, const std::shared_ptr<ServerConnection>& connection, const std::vector<const char *>& tokens)
+{
+	std::shared_ptr<AnalysisRequest> request(new AnalysisRequest());
+	request->connection = connection;
+	request->id = connection->nextRequestId++;
+	request->board = connection->board;
+	request->colour = connection->colour;
+	request->stop = false;
+
+	// the infinite request is searched until it is cancelled
+	const Notation::SearchLimits limits = Notation::ParseSearchCommand(tokens);
+	request->depth = limits.depth;
+	request->nodes = limits.nodes;
+	request->moveTime = limits.moveTime;
+
+	char line[64];
+	snprintf(line, sizeof(line), "queued %d", request->id);
+	connection->WriteLine(line);
+
+	std::lock_guard<std::mutex> lock(state.lock);
+	state.pending.push_back(request);
+	state.requestQueued.notify_one();
+}
+
+// handles the command line of the connection, returns false if the connection is to be closed
+static bool HandleCommand(ServerState& state, const std::shared_ptr<ServerConnection>& connection, const char * line)
+{
+	std::vector<char> buffer;
+	std::vector<const char *> tokens;
+	Notation::SplitCommand(line, buffer, tokens);
+	if(tokens.empty())
+		return true;
+
+	const char * command = tokens[0];
+	if(strcmp(command, "position") == 0)
+		SetPosition(state, *connection, tokens);
+	else if(strcmp(command, "go") == 0)
+		QueueRequest(state, connection, tokens);
+	else if(strcmp(command, "cancel") == 0)
+		CancelRequests(state, connection.get(), tokens.size() > 1 ? atoi(tokens[1]) : 0);
+	else if(strcmp(command, "isready") == 0)
+		connection->WriteLine("readyok");
+	else if(strcmp(command, "quit") == 0)
+		return false;
+	else
+	{
+		char response[MAX_LINE_LENGTH];
+		snprintf(response, sizeof(response), "error unknown command %s", command);
+		connection->WriteLine(response);
+	}
+	return true;
+}
+
+// reads the available data of the connection, returns false if the client closed it or it is to be closed
+static bool ReadConnection(ServerState& state, const std::shared_ptr<ServerConnection>& connection)
+{
+	char buffer[MAX_LINE_LENGTH];
+	const ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+	if(received < 0 && errno == EINTR)
+		return true;
+	if(received <= 0)
+		return false;
+
+	connection->input.append(buffer, (size_t) received);
+	for(size_t end = connection->input.find('\n'); end != std::string::npos; end = connection->input.find('\n'))
+	{
+		std::string line = connection->input.substr(0, end);
+		connection->input.erase(0, end + 1);
+		if(!HandleCommand(state, connection, line.c_str()))
+		{
+			CancelRequests(state, connection.get(), 0);
+			connection->closed = true;
+			return false;
+		}
+	}
+
+	if(connection->input.size() > (size_t) MAX_LINE_LENGTH)
+	{
+		connection->WriteLine("error line too long");
+		CancelRequests(state, connection.get(), 0);
+		connection->closed = true;
+		return false;
+	}
+	return true;
+}
+
+// stops the searches that ran out of their time
+static void CheckTimeLimits(ServerState& state)
+{
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(state.lock);
+	for(size_t i = 0; i < state.running.size(); ++i)
+	{
+		if(state.running[i]->moveTime > 0 && now >= state.running[i]->deadline)
+			state.running[i]->stop = true;
+	}
+}
+
+static int OpenSocket(const char * path)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(address.sun_path))
+		return -1;
+	strcpy(address.sun_path, path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+		return -1;
+
+	// the socket file of the previous run is removed
+	unlink(path);
+	if(bind(fd, (sockaddr *) &address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int main(int argc, char **argv)
+{
+	const char * socketPath = Config::SERVER_SOCKET_FILENAME;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	int hashSize = Config::SERVER_HASH_SIZE;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-socket") == 0 && i + 1 < argc)
+			socketPath = argv[++i];
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-hash") == 0 && i + 1 < argc)
+			hashSize = atoi(argv[++i]);
+		else
+		{
+			printf("Usage: server [-socket path] [-threads count] [-hash megabytes]\n");
+			return 1;
+		}
+	}
+	threadCount = Utils::Max(1, threadCount);
+	hashSize = Utils::Max(1, hashSize);
+
+	const int listenFd = OpenSocket(socketPath);
+	if(listenFd < 0)
+	{
+		printf("Could not listen on %s\n", socketPath);
+		return 1;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = OnSignal;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+
+	ServerState state;
+	state.movePool.Initalize();
+	state.table = new TransitionTable(TransitionTable::GetSizeForMegabytes(hashSize));
+	state.stopping = false;
+
+	std::vector<std::thread> workers;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		workers.push_back(std::thread(RunWorker, std::ref(state), t));
+	}
+	printf("Listening on %s with %d workers and %d MB of transition table\n", socketPath, threadCount, hashSize);
+	fflush(stdout);
+
+	std::map<int, std::shared_ptr<ServerConnection> > connections;
+	std::vector<pollfd> descriptors;
+	while(!shutdownRequested)
+	{
+		descriptors.clear();
+		pollfd listenDescriptor = { listenFd, POLLIN, 0 };
+		descriptors.push_back(listenDescriptor);
+		for(std::map<int, std::shared_ptr<ServerConnection> >::const_iterator it = connections.begin(); it != connections.end(); ++it)
+		{
+			pollfd descriptor = { it->first, POLLIN, 0 };
+			descriptors.push_back(descriptor);
+		}
+
+		const int ready = poll(&descriptors[0], descriptors.size(), POLL_TIMEOUT_MS);
+		CheckTimeLimits(state);
+		if(ready <= 0)
+			continue;
+
+		for(size_t i = 1; i < descriptors.size(); ++i)
+		{
+			if(descriptors[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				// the closed connection lives on in its requests until they are answered
+				if(!ReadConnection(state, connections[descriptors[i].fd]))
+					connections.erase(descriptors[i].fd);
+			}
+		}
+
+		if(descriptors[0].revents & POLLIN)
+		{
+			const int fd = accept(listenFd, nullptr, nullptr);
+			if(fd >= 0)
+			{
+				connections[fd] = std::shared_ptr<ServerConnection>(new ServerConnection(fd, &state.movePool));
+			}
+		}
+	}
+
+	// the queued requests are cancelled and the running ones stopped
+	std::deque<std::shared_ptr<AnalysisRequest> > cancelled;
+	{
+		std::lock_guard<std::mutex> lock(state.lock);
+		state.stopping = true;
+		cancelled.swap(state.pending);
+		for(size_t i = 0; i < state.running.size(); ++i)
+		{
+			state.running[i]->stop = true;
+		}
+		state.requestQueued.notify_all();
+	}
+	for(size_t i = 0; i < cancelled.size(); ++i)
+	{
+		WriteCancelled(*cancelled[i]);
+	}
+	for(int t = 0; t < threadCount; ++t)
+	{
+		workers[t].join();
+	}
+
+	cancelled.clear();
+	connections.clear();
+	close(listenFd);
+	unlink(socketPath);
+	delete state.table;
+	printf("Server stopped\n");
+	return 0;
+}
@@ -0,0 +1,417 @@
+// Retrograde generator of the distance to mate endgame tablebases
+// Usage: tablebase_generator [-dir directory] [-threads count] signature...
+// Example: tablebase_generator -dir data/tablebases KQvK KQvKR
+// The tables of all the materials reachable by captures are generated first (if they aren't in the directory already),
+// because the captures are looked up in them.
+// The first pass finds the mates and counts the moves of every position, every other pass takes the positions decided
+// in the previous one and un-moves them: the predecessors of a loss are won, a predecessor whose last move leads
+// to a won position is lost. After the first pass a position is set up only when it is decided, the generator keeps three
+// bytes per position.
+// Only the positions with the smallest index of their symmetric positions are generated, the moves to the symmetric
+// positions count as a single move (the un-moves from a position reach every parent position once).
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "tablebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+static const unsigned long long GENERATOR_CHUNK_SIZE = 4096;
+
+// the maximum distance must fit in the values below TABLEBASE_INVALID
+static const int GENERATOR_MAX_DISTANCE = Config::TABLEBASE_INVALID - 2;
+
+// the state shared by the generator threads for a single table
+struct GeneratorState
+{
+	const TablebaseMaterial * material;
+	const Tablebases * subTables; // the tables for the materials after a capture
+	BitBoardMovePool * movePool;
+	std::atomic<unsigned char> * values;
+	std::atomic<unsigned char> * moveCounts; // the moves within the table of the undecided positions, which don't lead to a won position yet
+	unsigned char * captureValues; // the best value reachable by a capture: a win, the shortest loss (without escape) or a draw
+	unsigned long long entryCount;
+	int pass; // 0 is the initialization pass, every other pass decides the positions with this distance to mate
+	std::atomic<unsigned long long> nextChunk;
+	std::atomic<unsigned long long> changed;
+	std::atomic<int> longestDistance; // the longest distance assigned so far
+	std::atomic<int> longestSubTableDistance; // the longest distance to mate reached by a capture
+	std::atomic<bool> overflow;
+};
+
+static void UpdateMaximum(std::atomic<int>& maximum, int value)
+{
+	int current = maximum.load(std::memory_order_relaxed);
+	while(value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{}
+}
+
+// assigns the value to the undecided position, returns false if it was already decided
+static bool Decide(GeneratorState& state, unsigned long long index, int distanceToMate)
+{
+	if(distanceToMate > GENERATOR_MAX_DISTANCE)
+	{
+		state.overflow = true;
+		return false;
+	}
+	unsigned char expected = Config::TABLEBASE_DRAW;
+	if(!state.values[index].compare_exchange_strong(expected, Tablebases::MakeValue(distanceToMate), std::memory_order_relaxed))
+		return false;
+	UpdateMaximum(state.longestDistance, distanceToMate);
+	return true;
+}
+
+// finds the mates, counts the moves and looks up the captures of every position
+static void InitializePositions(GeneratorState& state, Board& board, DynamicArray<Move>& moves, std::vector<unsigned long long>& children,
+	unsigned long long index, unsigned long long& changed)
+{
+	Config::PlayerColour colour = Config::WHITE;
+	// the index of the symmetric position with a smaller index stays invalid
+	if(!state.material->SetupBoard(index, board, colour) || state.material->GetIndex(board, colour, false) != index)
+	{
+		state.values[index].store(Config::TABLEBASE_INVALID, std::memory_order_relaxed);
+		return;
+	}
+
+	const Config::PlayerColour oppositeColour = Config::GetOppositePlayer(colour);
+	if(board.KingInCheck(oppositeColour))
+	{
+		state.values[index].store(Config::TABLEBASE_INVALID, std::memory_order_relaxed);
+		return;
+	}
+
+	moves.Clear();
+	board.GetPossibleMoves(colour, moves);
+	state.values[index].store(Config::TABLEBASE_DRAW, std::memory_order_relaxed);
+	state.moveCounts[index].store(0, std::memory_order_relaxed);
+	state.captureValues[index] = Config::TABLEBASE_DRAW;
+
+	// checkmate is a loss in zero plies, stalemate stays a draw
+	if(moves.Count() == 0)
+	{
+		if(board.KingInCheck(colour) && Decide(state, index, 0))
+			++changed;
+		return;
+	}
+
+	children.clear();
+	int shortestLoss = Config::INT_POSITIVE_INFINITY;
+	int longestWin = -1;
+	bool escape = false;
+	for(int i = 0; i < moves.Count(); ++i)
+	{
+		MadeMove move = board.MovePiece(moves[i].piece, moves[i].destination, moves[i].pieceMoves, true);
+		if(board.GetPieceCount() < state.material->GetPieceCount())
+		{
+			unsigned char value = Config::TABLEBASE_DRAW;
+			if(!state.subTables->ProbeValue(board, oppositeColour, value))
+				value = Config::TABLEBASE_DRAW;
+
+			if(Tablebases::IsLoss(value))
+				shortestLoss = Utils::Min(shortestLoss, Tablebases::GetDistanceToMate(value));
+			else if(Tablebases::IsWin(value))
+				longestWin = Utils::Max(longestWin, Tablebases::GetDistanceToMate(value));
+			else
+				escape = true;
+
+			if(value != Config::TABLEBASE_DRAW)
+				UpdateMaximum(state.longestSubTableDistance, Tablebases::GetDistanceToMate(value));
+		}
+		else
+		{
+			children.push_back(state.material->GetIndex(board, oppositeColour, false));
+		}
+		board.UndoMove(move);
+	}
+
+	// the moves to the symmetric positions are a single move, because the position is reached once by their un-moves
+	std::sort(children.begin(), children.end());
+	const int moveCount = (int) (std::unique(children.begin(), children.end()) - children.begin());
+
+	// the won captures are decided in the pass of their distance, the lost ones only raise the distance of the loss
+	int captureDistance = -1;
+	if(shortestLoss != Config::INT_POSITIVE_INFINITY)
+		captureDistance = shortestLoss + 1;
+	else if(!escape)
+		captureDistance = longestWin + 1;
+	if(captureDistance > GENERATOR_MAX_DISTANCE)
+	{
+		state.overflow = true;
+		captureDistance = GENERATOR_MAX_DISTANCE;
+	}
+	const unsigned char captureValue = (captureDistance >= 0 ? Tablebases::MakeValue(captureDistance) : Config::TABLEBASE_DRAW);
+	state.captureValues[index] = captureValue;
+	// NOTE: no position of the supported materials has more than 255 moves
+	state.moveCounts[index].store((unsigned char) moveCount, std::memory_order_relaxed);
+
+	// without moves within the table all the captures lead to won positions
+	if(moveCount == 0 && Tablebases::IsLoss(captureValue) && Decide(state, index, Tablebases::GetDistanceToMate(captureValue)))
+		++changed;
+}
+
+// un-moves the position decided in the previous pass, updating its undecided predecessors
+static void PropagatePosition(GeneratorState& state, Board& board, std::vector<unsigned long long>& parents, unsigned long long index,
+	unsigned long long& changed)
+{
+	Config::PlayerColour colour = Config::WHITE;
+	state.material->SetupBoard(index, board, colour);
+	const bool lost = Tablebases::IsLoss(state.values[index].load(std::memory_order_relaxed));
+
+	// the player not on move made the last move, which wasn't a capture (it would change the material)
+	const Config::PlayerColour mover = Config::GetOppositePlayer(colour);
+	const BitBoard emptyTiles = ~ (board.GetPiecesBitBoard(Config::WHITE) | board.GetPiecesBitBoard(Config::BLACK));
+	const DynamicArray<Piece> pieces = board.GetPieces(mover);
+	parents.clear();
+	for(int i = 0; i < pieces.Count(); ++i)
+	{
+		// all the pawnless pieces move the same way back, so the move sources are the empty tiles the piece sees
+		// (the full moves of the king and the knight, so the king may come from the threatened tiles too)
+		BitBoard sources = (Const::PIECE_MOVE_SCALING[pieces[i].GetType()]
+			? state.movePool->GetPieceMoves(pieces[i], board.GetPiecesBitBoard(mover), board.GetPiecesBitBoard(colour), &board)
+			: state.movePool->GetPieceFullMoves(pieces[i])) & emptyTiles;
+		for(coord source = sources.PopFirstBit(); source >= 0; source = sources.PopFirstBit())
+		{
+			MadeMove move = board.MovePiece(pieces[i], ChessVector(source), BitBoard(), true);
+			parents.push_back(state.material->GetIndex(board, mover, false));
+			board.UndoMove(move);
+		}
+	}
+
+	// the symmetric un-moves reach the same parent, which counted them as a single move
+	std::sort(parents.begin(), parents.end());
+	parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+	for(size_t i = 0; i < parents.size(); ++i)
+	{
+		const unsigned long long parent = parents[i];
+		if(state.values[parent].load(std::memory_order_relaxed) != Config::TABLEBASE_DRAW)
+			continue;
+
+		if(lost)
+		{
+			// the first loss reached is the shortest one, the passes go by the distance
+			if(Decide(state, parent, state.pass))
+				++changed;
+		}
+		else if(state.moveCounts[parent].fetch_sub(1, std::memory_order_relaxed) == 1)
+		{
+			// the last move to a won position, the captures can only make the loss longer or save the position
+			const unsigned char captureValue = state.captureValues[parent];
+			if(Tablebases::IsLoss(captureValue) && Decide(state, parent, Utils::Max(state.pass, Tablebases::GetDistanceToMate(captureValue))))
+				++changed;
+		}
+	}
+}
+
+static void GeneratePass(GeneratorState& state)
+{
+	Board board(state.movePool);
+	DynamicArray<Move> moves(Const::MAX_PIECES_MOVES);
+	std::vector<unsigned long long> indices;
+	unsigned long long changed = 0;
+	const unsigned char previousValue = Tablebases::MakeValue(state.pass - 1);
+
+	for(unsigned long long chunk = state.nextChunk++; chunk * GENERATOR_CHUNK_SIZE < state.entryCount; chunk = state.nextChunk++)
+	{
+		const unsigned long long last = Utils::Min((chunk + 1) * GENERATOR_CHUNK_SIZE, state.entryCount);
+		for(unsigned long long index = chunk * GENERATOR_CHUNK_SIZE; index < last; ++index)
+		{
+			if(state.pass == 0)
+			{
+				InitializePositions(state, board, moves, indices, index, changed);
+				continue;
+			}
+
+			const unsigned char value = state.values[index].load(std::memory_order_relaxed);
+			if(value == previousValue)
+			{
+				PropagatePosition(state, board, indices, index, changed);
+			}
+			else if(value == Config::TABLEBASE_DRAW && Tablebases::IsWin(state.captureValues[index])
+				&& Tablebases::GetDistanceToMate(state.captureValues[index]) == state.pass && Decide(state, index, state.pass))
+			{
+				// the capture wins in this pass, unless a shorter win was found already
+				++changed;
+			}
+		}
+	}
+	state.changed += changed;
+}
+
+static void RunWorkers(GeneratorState& state, int threadCount, void (*pass)(GeneratorState&))
+{
+	state.nextChunk = 0;
+	std::vector<std::thread> workers;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		workers.push_back(std::thread(pass, std::ref(state)));
+	}
+	for(int t = 0; t < threadCount; ++t)
+	{
+		workers[t].join();
+	}
+}
+
+static bool GenerateTable(const TablebaseMaterial& material, const Tablebases& subTables, BitBoardMovePool * movePool, const char * directory, int threadCount)
+{
+	char signature[Config::TABLEBASE_MAX_SIGNATURE] = "";
+	material.GetSignature(signature);
+
+	GeneratorState state;
+	state.material = &material;
+	state.subTables = &subTables;
+	state.movePool = movePool;
+	state.entryCount = material.GetEntryCount();
+	state.values = new std::atomic<unsigned char>[(size_t) state.entryCount];
+	state.moveCounts = new std::atomic<unsigned char>[(size_t) state.entryCount];
+	state.captureValues = new unsigned char[(size_t) state.entryCount];
+	state.longestDistance = 0;
+	state.longestSubTableDistance = 0;
+	state.overflow = false;
+
+	printf("Generating %s (%llu positions)\n", signature, state.entryCount);
+
+	// the passes can be empty while a longer distance waits behind a capture to a sub table,
+	// so the generation ends only after the longest distance reached by the captures
+	bool finished = false;
+	for(int pass = 0; pass <= GENERATOR_MAX_DISTANCE + 1 && !finished && !state.overflow; ++pass)
+	{
+		state.pass = pass;
+		state.changed = 0;
+		RunWorkers(state, threadCount, GeneratePass);
+
+		printf("  pass %d: %llu positions\n", pass, (unsigned long long) state.changed);
+		finished = pass > state.longestDistance && pass > state.longestSubTableDistance;
+	}
+	delete[] state.moveCounts;
+	delete[] state.captureValues;
+
+	if(!finished || state.overflow)
+	{
+		printf("The distance to mate of %s doesn't fit in the table format\n", signature);
+		delete[] state.values;
+		return false;
+	}
+
+	char filename[SysConfig::MAX_PATH];
+	Tablebases::GetFilename(material, directory, filename, sizeof(filename));
+	FILE * output = fopen(filename, "wb");
+	if(!output)
+	{
+		printf("Could not open %s for writing\n", filename);
+		delete[] state.values;
+		return false;
+	}
+
+	TablebaseHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, Config::TABLEBASE_MAGIC, sizeof(header.magic));
+	memcpy(header.signature, signature, sizeof(header.signature) - 1);
+	header.signature[sizeof(header.signature) - 1] = '\0';
+	header.entryCount = state.entryCount;
+	fwrite(&header, sizeof(header), 1, output);
+
+	std::vector<unsigned char> buffer((size_t) GENERATOR_CHUNK_SIZE);
+	for(unsigned long long first = 0; first < state.entryCount; first += GENERATOR_CHUNK_SIZE)
+	{
+		const unsigned long long count = Utils::Min(GENERATOR_CHUNK_SIZE, state.entryCount - first);
+		for(unsigned long long i = 0; i < count; ++i)
+		{
+			buffer[(size_t) i] = state.values[first + i].load(std::memory_order_relaxed);
+		}
+		fwrite(&buffer[0], 1, (size_t) count, output);
+	}
+	fclose(output);
+	delete[] state.values;
+
+	printf("Written %s\n", filename);
+	return true;
+}
+
+// adds the material after all the sub materials, reachable by captures
+static void AddWithSubMaterials(const TablebaseMaterial& material, std::vector<TablebaseMaterial>& ordered)
+{
+	for(size_t i = 0; i < ordered.size(); ++i)
+	{
+		if(ordered[i].GetKey() == material.GetKey())
+			return;
+	}
+	for(int slot = 0; slot < material.GetPieceCount(); ++slot)
+	{
+		if(material.GetType(slot) != Config::KING)
+		{
+			AddWithSubMaterials(material.RemovePiece(slot), ordered);
+		}
+	}
+	ordered.push_back(material);
+}
+
+int main(int argc, char **argv)
+{
+	const char * directory = Config::TABLEBASE_DIRECTORY;
+	int threadCount = (int) std::thread::hardware_concurrency();
+	std::vector<TablebaseMaterial> ordered;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-dir") == 0 && i + 1 < argc)
+		{
+			directory = argv[++i];
+		}
+		else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threadCount = atoi(argv[++i]);
+		}
+		else
+		{
+			TablebaseMaterial material;
+			if(!material.FromSignature(argv[i]) || material.GetPieceCount() > Config::TABLEBASE_MAX_PIECES)
+			{
+				printf("Invalid material %s\n", argv[i]);
+				return 1;
+			}
+			AddWithSubMaterials(material, ordered);
+		}
+	}
+
+	if(ordered.empty())
+	{
+		printf("Usage: tablebase_generator [-dir directory] [-threads count] signature...\n");
+		return 1;
+	}
+	threadCount = Utils::Max(1, threadCount);
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	Tablebases tablebases;
+	tablebases.Load(directory);
+
+	for(size_t i = 0; i < ordered.size(); ++i)
+	{
+		char signature[Config::TABLEBASE_MAX_SIGNATURE] = "";
+		ordered[i].GetSignature(signature);
+		char filename[SysConfig::MAX_PATH];
+		Tablebases::GetFilename(ordered[i], directory, filename, sizeof(filename));
+
+		if(ordered[i].IsDrawnByMaterial())
+		{
+			printf("%s is a draw by the game rules, no table is needed\n", signature);
+		}
+		else if(tablebases.HasTable(ordered[i]))
+		{
+			printf("%s is already generated\n", signature);
+		}
+		else if(!GenerateTable(ordered[i], tablebases, &movePool, directory, threadCount) || !tablebases.AddTable(filename))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,413 @@
+// Texel style tuner of the evaluation weights
+// Usage: tuner [-threads count] [-epochs count] [-rate learning rate] [-limit positions] positions_file [weights_file]
+// Every labeled position is resolved by a captures only quiescence search, and the features of the quiet leaf are taken.
+// The piece worth, the position worth factors and the pawn advancement worth are then fitted by gradient descent
+// on the logistic loss between the evaluation and the game results. The result is written as a weights file that
+// the game loads (see PieceSquareTable::Load). The mobility and pawn structure terms are kept as they are.
+
+#include "configuration.h"
+#include "constants.h"
+#include "board.h"
+#include "piecesquaretable.h"
+#include "positionrecord.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+// the tuned weights: piece worth (queen to pawn), position worth factors (king to pawn) and the pawn advancement worth
+static const int WORTH_WEIGHTS = Config::PIECE_TYPE_COUNT - Config::QUEEN;
+static const int FACTOR_WEIGHTS = Config::PIECE_TYPE_COUNT - Config::KING;
+static const int WEIGHT_COUNT = WORTH_WEIGHTS + FACTOR_WEIGHTS + 1;
+static const int PAWN_ADVANCEMENT_WEIGHT = WEIGHT_COUNT - 1;
+
+static const int QUIESCENCE_MAX_PLY = 8;
+
+// the features of a quiet position (white minus black), the evaluation is fixed + dot(weights, features)
+struct TunerSample
+{
+	float features[WEIGHT_COUNT];
+	float fixed;
+	float target;
+};
+
+// the classical evaluation from the point of view of the player on move
+static int Evaluate(const Board& board, Config::PlayerColour colour)
+{
+	PawnStructure pawnStructure;
+	board.EvaluatePawnStructure(pawnStructure);
+	const int balance = board.GetMaterialBalance() + pawnStructure.score;
+	return (colour == Config::WHITE ? balance : -balance);
+}
+
+// captures only negamax search, collecting the principal variation, so the quiet leaf can be reached
+class Quiescence
+{
+public:
+	Quiescence()
+	{
+		for(int i = 0; i < QUIESCENCE_MAX_PLY + 1; ++i)
+		{
+			moves[i].Alloc(Const::MAX_PIECES_MOVES);
+		}
+	}
+
+	int Search(Board& board, Config::PlayerColour colour, int alpha, int beta, int ply)
+	{
+		pvLength[ply] = ply;
+		const int standPat = Evaluate(board, colour);
+		if(standPat >= beta || ply >= QUIESCENCE_MAX_PLY)
+			return standPat;
+		alpha = Utils::Max(alpha, standPat);
+
+		DynamicArray<Move>& captures = moves[ply];
+		captures.Clear();
+		board.GetPossibleMoves(colour, captures);
+
+		// keep only the captures, the most valuable victim first
+		const BitBoard enemyPieces = board.GetPiecesBitBoard(Config::GetOppositePlayer(colour));
+		for(int i = captures.Count() - 1; i >= 0; --i)
+		{
+			if(!enemyPieces.GetBit(captures[i].destination.GetVectorCoord()))
+			{
+				captures.RemoveItem(i);
+			}
+			else
+			{
+				captures[i].heuristic = board.GetPiece(captures[i].destination).GetWorth() * 16 - captures[i].piece.GetWorth();
+			}
+		}
+		captures.Sort();
+
+		for(int i = 0; i < captures.Count(); ++i)
+		{
+			MadeMove move = board.MovePiece(captures[i].piece, captures[i].destination, captures[i].pieceMoves, true);
+			const int score = -Search(board, Config::GetOppositePlayer(colour), -beta, -alpha, ply + 1);
+			board.UndoMove(move);
+
+			if(score > alpha)
+			{
+				alpha = score;
+				pv[ply][ply] = captures[i];
+				for(int next = ply + 1; next < pvLength[ply + 1]; ++next)
+				{
+					pv[ply][next] = pv[ply + 1][next];
+				}
+				pvLength[ply] = pvLength[ply + 1];
+				if(alpha >= beta)
+					break;
+			}
+		}
+		return alpha;
+	}
+
+	// plays the principal variation of the last search on the board
+	Config::PlayerColour PlayPrincipalVariation(Board& board, Config::PlayerColour colour) const
+	{
+		for(int i = 0; i < pvLength[0]; ++i)
+		{
+			board.MovePiece(pv[0][i].piece, pv[0][i].destination, pv[0][i].pieceMoves, true);
+			colour = Config::GetOppositePlayer(colour);
+		}
+		return colour;
+	}
+
+private:
+	DynamicArray<Move> moves[QUIESCENCE_MAX_PLY + 1];
+	Move pv[QUIESCENCE_MAX_PLY + 1][QUIESCENCE_MAX_PLY + 1];
+	int pvLength[QUIESCENCE_MAX_PLY + 1];
+};
+
+static void ExtractFeatures(const Board& board, TunerSample& sample)
+{
+	for(int i = 0; i < WEIGHT_COUNT; ++i)
+	{
+		sample.features[i] = 0.0f;
+	}
+
+	for(int colour = 0; colour < Config::PCOLOUR_COUNT; ++colour)
+	{
+		const float sign = (colour == Config::WHITE ? 1.0f : -1.0f);
+		const ChessVector reproduction = Const::PAWN_REPRODUCE_VECTORS[colour];
+		const DynamicArray<Piece>& pieces = board.GetPieces((Config::PlayerColour) colour);
+		for(int i = 0; i < pieces.Count(); ++i)
+		{
+			const Config::PieceType type = pieces[i].GetType();
+			const ChessVector pos = pieces[i].GetPositionVector();
+			if(type != Config::KING)
+			{
+				sample.features[type - Config::QUEEN] += sign;
+			}
+			sample.features[WORTH_WEIGHTS + type - Config::KING] += sign * pos.GetManhattanDistance(Const::BOARD_CENTER);
+			if(type == Config::PAWN)
+			{
+				sample.features[PAWN_ADVANCEMENT_WEIGHT] += sign * (Const::PAWN_DISTANCE_TO_REPRODUCTION - Utils::Abs(pos.y - reproduction.y) - Utils::Abs(pos.z - reproduction.z));
+			}
+		}
+	}
+}
+
+static float Dot(const float * weights, const TunerSample& sample)
+{
+	float eval = sample.fixed;
+	for(int i = 0; i < WEIGHT_COUNT; ++i)
+	{
+		eval += weights[i] * sample.features[i];
+	}
+	return eval;
+}
+
+static double Sigmoid(double scale, double eval)
+{
+	return 1.0 / (1.0 + exp(-scale * eval));
+}
+
+// the mean logistic loss and (optionally) its gradient for the weights, calculated by all the threads
+static double ComputeLoss(const std::vector<TunerSample>& samples, const float * weights, double scale, double * gradient, int threadCount)
+{
+	std::vector<double> losses(threadCount, 0.0);
+	std::vector< std::vector<double> > gradients(threadCount, std::vector<double>(WEIGHT_COUNT, 0.0));
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads.push_back(std::thread([&, t] ()
+		{
+			const size_t begin = samples.size() * t / threadCount;
+			const size_t end = samples.size() * (t + 1) / threadCount;
+			for(size_t i = begin; i < end; ++i)
+			{
+				const double eval = Dot(weights, samples[i]);
+				const double predicted = Utils::Min(Utils::Max(Sigmoid(scale, eval), 1e-9), 1.0 - 1e-9);
+				const double target = samples[i].target;
+				losses[t] -= target * log(predicted) + (1.0 - target) * log(1.0 - predicted);
+				if(gradient)
+				{
+					// d loss / d eval of the logistic loss is scale * (predicted - target)
+					const double delta = scale * (predicted - target);
+					for(int w = 0; w < WEIGHT_COUNT; ++w)
+					{
+						gradients[t][w] += delta * samples[i].features[w];
+					}
+				}
+			}
+		}));
+	}
+
+	double loss = 0.0;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		threads[t].join();
+		loss += losses[t];
+		for(int w = 0; w < WEIGHT_COUNT && gradient; ++w)
+		{
+			gradient[w] += gradients[t][w];
+		}
+	}
+
+	const double count = (double) Utils::Max<size_t>(samples.size(), 1);
+	for(int w = 0; w < WEIGHT_COUNT && gradient; ++w)
+	{
+		gradient[w] /= count;
+	}
+	return loss / count;
+}
+
+// resolves the positions from the reader until the file ends (or the limit is reached)
+static void ResolvePositions(PositionRecordReader& reader, std::mutex& readerLock, long long& remaining, BitBoardMovePool * movePool,
+	const float * initialWeights, std::vector<TunerSample>& samples)
+{
+	std::vector<PositionRecord> records(Config::POSITION_RECORD_BUFFER);
+	Quiescence quiescence;
+	Board board(movePool);
+	for(;;)
+	{
+		int count = 0;
+		{
+			std::lock_guard<std::mutex> lock(readerLock);
+			count = (int) Utils::Min<long long>(remaining, Config::POSITION_RECORD_BUFFER);
+			count = reader.Read(&records[0], count);
+			remaining -= count;
+		}
+		if(count <= 0)
+			break;
+
+		for(int i = 0; i < count; ++i)
+		{
+			records[i].ToBoard(board);
+			Config::PlayerColour colour = (Config::PlayerColour) records[i].colourToMove;
+			if(board.KingInCheck(Config::GetOppositePlayer(colour)))
+				continue;
+
+			quiescence.Search(board, colour, Config::INT_NEGATIVE_INFINITY + 1, Config::INT_POSITIVE_INFINITY, 0);
+			colour = quiescence.PlayPrincipalVariation(board, colour);
+
+			TunerSample sample;
+			ExtractFeatures(board, sample);
+			sample.target = records[i].GetWhiteScore();
+
+			// everything that isn't tuned is kept as a fixed part of the evaluation
+			sample.fixed = 0.0f;
+			sample.fixed = (float) Evaluate(board, Config::WHITE) - Dot(initialWeights, sample);
+			samples.push_back(sample);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int threadCount = (int) std::thread::hardware_concurrency();
+	int epochs = 1000;
+	double learningRate = 0.5;
+	long long limit = -1;
+	const char * inputFilename = nullptr;
+	const char * outputFilename = Config::PIECE_SQUARE_TABLE_FILENAME;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-epochs") == 0 && i + 1 < argc)
+			epochs = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-rate") == 0 && i + 1 < argc)
+			learningRate = atof(argv[++i]);
+		else if(strcmp(argv[i], "-limit") == 0 && i + 1 < argc)
+			limit = atoll(argv[++i]);
+		else if(!inputFilename)
+			inputFilename = argv[i];
+		else
+			outputFilename = argv[i];
+	}
+
+	if(!inputFilename)
+	{
+		printf("Usage: tuner [-threads count] [-epochs count] [-rate learning rate] [-limit positions] positions_file [weights_file]\n");
+		return 1;
+	}
+	threadCount = Utils::Max(1, threadCount);
+
+	PositionRecordReader reader;
+	if(!reader.Open(inputFilename))
+	{
+		printf("Could not open the positions file %s\n", inputFilename);
+		return 1;
+	}
+
+	BitBoardMovePool movePool;
+	movePool.Initalize();
+
+	// the starting weights are the ones the tables were generated with
+	float weights[WEIGHT_COUNT];
+	for(int type = Config::QUEEN; type < Config::PIECE_TYPE_COUNT; ++type)
+	{
+		weights[type - Config::QUEEN] = (float) PieceSquareTable::GetPieceWorth((Config::PieceType) type);
+	}
+	for(int type = Config::KING; type < Config::PIECE_TYPE_COUNT; ++type)
+	{
+		weights[WORTH_WEIGHTS + type - Config::KING] = (float) Const::PIECE_POSITION_WORTH_FACTOR[type];
+	}
+	weights[PAWN_ADVANCEMENT_WEIGHT] = (float) Const::PAWN_ADVANCEMENT_WORTH;
+
+	// resolve all the positions in parallel
+	std::vector< std::vector<TunerSample> > threadSamples(threadCount);
+	std::mutex readerLock;
+	long long remaining = (limit >= 0 ? limit : (~0ULL >> 1));
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::thread> threads;
+		for(int t = 0; t < threadCount; ++t)
+		{
+			threads.push_back(std::thread(ResolvePositions, std::ref(reader), std::ref(readerLock), std::ref(remaining), &movePool, weights, std::ref(threadSamples[t])));
+		}
+		for(int t = 0; t < threadCount; ++t)
+		{
+			threads[t].join();
+		}
+	}
+	reader.Close();
+
+	std::vector<TunerSample> samples;
+	for(int t = 0; t < threadCount; ++t)
+	{
+		samples.insert(samples.end(), threadSamples[t].begin(), threadSamples[t].end());
+		std::vector<TunerSample>().swap(threadSamples[t]);
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Resolved %d positions in %.2fs (%.0f positions/s per core)\n", (int) samples.size(), seconds, samples.size() / Utils::Max(seconds, 1e-6) / threadCount);
+	if(samples.empty())
+		return 1;
+
+	// find the sigmoid scale that fits the starting weights best
+	double scale = 0.01;
+	{
+		double low = 0.0001;
+		double high = 0.5;
+		for(int i = 0; i < 40; ++i)
+		{
+			const double left = low + (high - low) / 3.0;
+			const double right = high - (high - low) / 3.0;
+			if(ComputeLoss(samples, weights, left, nullptr, threadCount) < ComputeLoss(samples, weights, right, nullptr, threadCount))
+				high = right;
+			else
+				low = left;
+		}
+		scale = (low + high) * 0.5;
+	}
+	printf("Sigmoid scale %.5f, starting loss %.6f\n", scale, ComputeLoss(samples, weights, scale, nullptr, threadCount));
+
+	// adam gradient descent
+	double moment[WEIGHT_COUNT] = {0.0};
+	double velocity[WEIGHT_COUNT] = {0.0};
+	const double beta1 = 0.9;
+	const double beta2 = 0.999;
+	start = std::chrono::steady_clock::now();
+	double loss = 0.0;
+	for(int epoch = 1; epoch <= epochs; ++epoch)
+	{
+		double gradient[WEIGHT_COUNT] = {0.0};
+		loss = ComputeLoss(samples, weights, scale, gradient, threadCount);
+		for(int w = 0; w < WEIGHT_COUNT; ++w)
+		{
+			moment[w] = beta1 * moment[w] + (1.0 - beta1) * gradient[w];
+			velocity[w] = beta2 * velocity[w] + (1.0 - beta2) * gradient[w] * gradient[w];
+			const double correctedMoment = moment[w] / (1.0 - pow(beta1, epoch));
+			const double correctedVelocity = velocity[w] / (1.0 - pow(beta2, epoch));
+			weights[w] -= (float) (learningRate * correctedMoment / (sqrt(correctedVelocity) + 1e-8));
+		}
+
+		if(epoch % 100 == 0 || epoch == epochs)
+		{
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			printf("Epoch %d: loss %.6f (%.0f positions/s per core)\n", epoch, loss, (double) samples.size() * epoch / Utils::Max(seconds, 1e-6) / threadCount);
+		}
+	}
+
+	// write the tuned weights in the format the game loads
+	int factors[Config::PIECE_TYPE_COUNT];
+	factors[Config::NO_TYPE] = Const::PIECE_POSITION_WORTH_FACTOR[Config::NO_TYPE];
+	printf("Tuned weights:\n");
+	for(int type = Config::KING; type < Config::PIECE_TYPE_COUNT; ++type)
+	{
+		factors[type] = (int) floorf(weights[WORTH_WEIGHTS + type - Config::KING] + 0.5f);
+		if(type != Config::KING)
+		{
+			PieceSquareTable::SetPieceWorth((Config::PieceType) type, (int) floorf(weights[type - Config::QUEEN] + 0.5f));
+		}
+		printf("%s: worth %d, position factor %d\n", Const::PIECE_NAMES[type].GetPtr(), PieceSquareTable::GetPieceWorth((Config::PieceType) type), factors[type]);
+	}
+	const int pawnAdvancement = (int) floorf(weights[PAWN_ADVANCEMENT_WEIGHT] + 0.5f);
+	printf("Pawn advancement: %d\n", pawnAdvancement);
+	PieceSquareTable::Generate(factors, pawnAdvancement);
+
+	if(!PieceSquareTable::Save(outputFilename))
+	{
+		printf("Could not write the weights file %s\n", outputFilename);
+		return 1;
+	}
+	printf("Written %s\n", outputFilename);
+	return 0;
+}